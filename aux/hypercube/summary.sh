@@ -2,6 +2,7 @@
 # 
 # Parses the simulation and outputs the mean and stdev prevalence results for each population and sample type.
 # Run this script after building the multitown simulation.
+# The summarize executable builds the same table (for every RR and group) in a single parallel pass.
 
 if [ $# -ne 2 ]; then
   echo "Needs two input parameters:"
@@ -14,15 +14,14 @@
 
 namespace sampsim
 {
-  void base_object::debug( std::string message, ... ) const
+  void base_object::debug( const char *message, ... ) const
   {
     if( this->debug_mode )
     {
       va_list args;
       va_start( args, message );
-
-      message = "DEBUG[" + this->get_name() + "]: " + message;
-      utilities::output( message, args );
+      utilities::output( "DEBUG[" + this->get_name() + "]: " + message, args );
+      va_end( args );
     }
   }
 }
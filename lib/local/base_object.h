@@ -13,6 +13,33 @@
 
 namespace Json { class Value; }
 
+/**
+ * The highest level of debug message compiled into the library
+ * 
+ * 0: no debug messages, 1: debug messages, 2: debug and trace messages (from frequently called methods)
+ */
+#ifndef SAMPSIM_DEBUG_LEVEL
+  #define SAMPSIM_DEBUG_LEVEL 2
+#endif
+
+/**
+ * Macros used to output debug messages from within base_object methods
+ * 
+ * Unlike calling debug() directly the message's arguments are only evaluated when the object's
+ * debug_mode is on, and the macros compile to nothing when their level is above SAMPSIM_DEBUG_LEVEL.
+ */
+#if 1 <= SAMPSIM_DEBUG_LEVEL
+  #define SAMPSIM_DEBUG( ... ) do { if( this->debug_mode ) this->debug( __VA_ARGS__ ); } while( false )
+#else
+  #define SAMPSIM_DEBUG( ... ) do {} while( false )
+#endif
+
+#if 2 <= SAMPSIM_DEBUG_LEVEL
+  #define SAMPSIM_TRACE( ... ) do { if( this->debug_mode ) this->debug( __VA_ARGS__ ); } while( false )
+#else
+  #define SAMPSIM_TRACE( ... ) do {} while( false )
+#endif
+
 /**
  * @addtogroup sampsim
  * @{
@@ -76,9 +103,10 @@ namespace sampsim
     /**
      * Used to display debug messages to the standard output.
      * 
-     * This method will only display messages if the "debug_mode" member is true.
+     * This method will only display messages if the "debug_mode" member is true.  Use the
+     * SAMPSIM_DEBUG and SAMPSIM_TRACE macros instead of calling this method directly.
      */
-    void debug( std::string message, ... ) const;
+    void debug( const char *message, ... ) const;
   };
 }
 
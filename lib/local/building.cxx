@@ -8,6 +8,8 @@
 
 #include "building.h"
 
+#include "csv_writer.h"
+#include "distribution.h"
 #include "household.h"
 #include "population.h"
 #include "summary.h"
@@ -18,6 +20,7 @@
 #include <json/value.h>
 #include <random>
 #include <stdexcept>
+#include <vector>
 
 namespace sampsim
 {
@@ -51,18 +54,39 @@ namespace sampsim
     return NULL == this->parent ? NULL : this->parent->get_population();
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  coordinate building::draw_position( const tile *tile )
+  {
+    extent_type extent = tile->get_extent();
+    coordinate position;
+    position.x = utilities::random() * safe_subtract( extent.second.x, extent.first.x ) + extent.first.x;
+    position.y = utilities::random() * safe_subtract( extent.second.y, extent.first.y ) + extent.first.y;
+    return position;
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void building::create()
   {
     // make sure the building has a parent
     if( NULL == this->parent ) throw std::runtime_error( "Tried to create an orphaned building" );
 
-    // determine the building's position
-    town* town = this->get_town();
-    extent_type extent = this->get_tile()->get_extent();
-    this->position.x = utilities::random() * safe_subtract( extent.second.x, extent.first.x ) + extent.first.x;
-    this->position.y = utilities::random() * safe_subtract( extent.second.y, extent.first.y ) + extent.first.y;
-    this->position.set_centroid( town->get_centroid() );
+    coordinate position = building::draw_position( this->parent );
+    std::vector< sex_type > sex_list;
+    household::draw_members( this->get_town(), sex_list );
+    this->create( position, sex_list.size(), sex_list.data() );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void building::create(
+    const coordinate &position,
+    const std::vector< sex_type >::size_type size,
+    const sex_type *sex_list )
+  {
+    // make sure the building has a parent
+    if( NULL == this->parent ) throw std::runtime_error( "Tried to create an orphaned building" );
+
+    this->position = position;
+    this->position.set_centroid( this->get_town()->get_centroid() );
 
     // check if the building is in a river and move it to the nearest bank if it is
     if( this->in_river() )
@@ -86,7 +110,7 @@ namespace sampsim
 
     // for now we're only allowing one household per building
     household *h = new household( this );
-    h->create();
+    h->create( size, sex_list );
     this->household_list.push_back( h );
 
     // cache the number-of-individuals
@@ -96,35 +120,27 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void building::define()
   {
-    for( auto it = this->household_list.begin(); it != this->household_list.end(); ++it ) (*it)->define();
+    std::vector< coordinate > position_list( this->household_list.size(), this->position );
+    std::vector< double > trend_list( trend_field::NUMBER_OF_FIELDS * position_list.size() );
+    this->get_town()->get_trend_field()->evaluate(
+      position_list.size(), position_list.data(), trend_list.data() );
+    std::vector< double > normal_list( 3 * this->household_list.size() );
+    distribution::generate_independent_normal_values( normal_list.size(), normal_list.data() );
+    this->define( normal_list.data(), trend_list.data() );
+  }
 
-    // determine the pocket factor
-    population* pop = this->get_population();
-    town* town = this->get_town();
-    this->pocket_factor = 0.0;
-    for( auto it = town->get_disease_pocket_list_cbegin(); it != town->get_disease_pocket_list_cend(); ++it )
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void building::define( const double *normal_values, const double *trend_values )
+  {
+    for( auto it = this->household_list.begin(); it != this->household_list.end(); ++it )
     {
-      double distance = this->position.distance( *it ) / pop->get_pocket_scaling();
-      std::string type = pop->get_pocket_kernel_type();
-      if( "exponential" == type )
-      {
-        this->pocket_factor += exp( -distance );
-      }
-      else if( "inverse_square" == type )
-      {
-        this->pocket_factor += 1 / ( distance * distance );
-      }
-      else if( "gaussian" == type )
-      {
-        this->pocket_factor += exp( -( distance * distance ) );
-      }
-      else
-      {
-        std::stringstream stream;
-        stream << "Using unknown disease pocket kernel type \"" << type << "\"";
-        throw std::runtime_error( stream.str() );
-      }
+      (*it)->define( normal_values, trend_values );
+      normal_values += 3;
+      trend_values += trend_field::NUMBER_OF_FIELDS;
     }
+
+    // determine the pocket factor
+    this->pocket_factor = this->get_town()->get_pocket_field()->get_factor( this->position );
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -164,33 +180,40 @@ namespace sampsim
     }
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void building::to_csv( std::ostream &household_stream, std::ostream &individual_stream ) const
+  {
+    csv_writer household_writer, individual_writer;
+    this->to_csv( household_writer, individual_writer );
+    household_stream << household_writer.str();
+    individual_stream << individual_writer.str();
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void building::to_csv(
-    std::ostream &household_stream, std::ostream &individual_stream ) const
+    csv_writer &household_writer, csv_writer &individual_writer ) const
   {
     bool sample_mode = this->get_population()->get_sample_mode();
     for( auto it = this->household_list.begin(); it != this->household_list.end(); ++it )
     {
       household *h = *it;
-      if( !sample_mode || h->is_selected() ) h->to_csv( household_stream, individual_stream );
+      if( !sample_mode || h->is_selected() ) h->to_csv( household_writer, individual_writer );
     }
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void building::assert_summary()
   {
+    // buildings don't keep their summary so it is rebuilt from their households' every time it is requested
     this->get_population()->assert_summary();
+    this->rebuild_summary();
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void building::rebuild_summary()
   {
-    this->sum.reset();
-    for( auto it = this->household_list.begin(); it != this->household_list.end(); ++it )
-    {
-      (*it)->rebuild_summary();
-      this->sum.add( (*it) );
-    }
+    summary *sum = this->reset_summary();
+    for( auto it = this->household_list.begin(); it != this->household_list.end(); ++it ) sum->add( *it );
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -22,6 +22,7 @@ namespace Json { class Value; }
 
 namespace sampsim
 {
+  class csv_writer;
   class household;
   class population;
   class town;
@@ -80,6 +81,11 @@ namespace sampsim
     void unselect();
     void select_all();
 
+    /**
+     * Output object to two CSV writers (households and individuals)
+     */
+    void to_csv( csv_writer&, csv_writer& ) const;
+
     /**
      * Iterator access to child households
      * 
@@ -166,6 +172,29 @@ namespace sampsim
     void create();
     void define();
 
+    /**
+     * Creates the building at a pre-drawn position with one household of pre-drawn members
+     * 
+     * The position is moved to the nearest river bank if it falls in the tile's river.  See
+     * household::draw_members() for how the member sexes are drawn.
+     */
+    void create(
+      const coordinate &position,
+      const std::vector< sex_type >::size_type size,
+      const sex_type *sex_list );
+
+    /**
+     * Draws a random position within the given tile's extent
+     */
+    static coordinate draw_position( const tile* );
+
+    /**
+     * Defines the building using pre-drawn normal values and pre-evaluated trends for each household
+     * 
+     * See household::define() for the number and order of values used by each household.
+     */
+    void define( const double *normal_values, const double *trend_values );
+
   private:
     /**
      * A reference to the tile that the building belongs to (not reference counted)
@@ -0,0 +1,163 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   cluster_variance.cxx
+  Language: C++
+
+=========================================================================*/
+
+#include "cluster_variance.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <thread>
+
+namespace sampsim
+{
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void cluster_variance::clear()
+  {
+    this->selected_list.clear();
+    this->diseased_list.clear();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void cluster_variance::add_cluster( const double selected, const double diseased )
+  {
+    this->selected_list.push_back( selected );
+    this->diseased_list.push_back( diseased );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  double cluster_variance::get_proportion() const
+  {
+    double sum_m = std::accumulate( this->selected_list.cbegin(), this->selected_list.cend(), 0.0 );
+    double sum_y = std::accumulate( this->diseased_list.cbegin(), this->diseased_list.cend(), 0.0 );
+    return sum_y / sum_m;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  double cluster_variance::get_total_selected() const
+  {
+    return std::accumulate( this->selected_list.cbegin(), this->selected_list.cend(), 0.0 );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  double cluster_variance::get_ratio_variance() const
+  {
+    const double n = this->get_number_of_clusters();
+    if( 2 > n ) return std::numeric_limits< double >::quiet_NaN();
+
+    // "m" represents the number of selected individuals and "y" the number of selected diseased individuals
+    double proportion = this->get_proportion(), sum_m = 0, sum_residual = 0;
+    for( unsigned int c = 0; c < n; c++ )
+    {
+      double residual = this->diseased_list[c] - proportion * this->selected_list[c];
+      sum_m += this->selected_list[c];
+      sum_residual += residual * residual;
+    }
+
+    double mean_m = sum_m / n;
+    return sum_residual / ( n * ( n - 1 ) * mean_m * mean_m );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  double cluster_variance::get_jackknife_variance() const
+  {
+    const double n = this->get_number_of_clusters();
+    if( 2 > n ) return std::numeric_limits< double >::quiet_NaN();
+
+    // each replicate is the total minus one cluster, so there is no need to re-sum the others
+    double sum_m = std::accumulate( this->selected_list.cbegin(), this->selected_list.cend(), 0.0 );
+    double sum_y = std::accumulate( this->diseased_list.cbegin(), this->diseased_list.cend(), 0.0 );
+    std::vector< double > estimate_list( this->get_number_of_clusters() );
+    for( unsigned int c = 0; c < n; c++ )
+      estimate_list[c] = ( sum_y - this->diseased_list[c] ) / ( sum_m - this->selected_list[c] );
+
+    double mean = std::accumulate( estimate_list.cbegin(), estimate_list.cend(), 0.0 ) / n, squared_sum = 0;
+    for( auto it = estimate_list.cbegin(); it != estimate_list.cend(); ++it )
+      squared_sum += ( *it - mean ) * ( *it - mean );
+    return ( n - 1 ) / n * squared_sum;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  double cluster_variance::get_bootstrap_variance(
+    const unsigned int replicates, const unsigned int seed, const unsigned int threads ) const
+  {
+    const unsigned int n = this->get_number_of_clusters();
+    if( 2 > n || 2 > replicates ) return std::numeric_limits< double >::quiet_NaN();
+
+    std::vector< double > estimate_list( replicates );
+    const unsigned int blocks = ( replicates + REPLICATE_BLOCK_SIZE - 1 ) / REPLICATE_BLOCK_SIZE;
+    std::atomic< unsigned int > next( 0 );
+    auto worker = [&]()
+    {
+      std::uniform_int_distribution< unsigned int > distribution( 0, n - 1 );
+      for( unsigned int block = next++; block < blocks; block = next++ )
+      {
+        std::seed_seq sequence{ seed, block };
+        std::mt19937 engine( sequence );
+        unsigned int last = std::min( replicates, ( block + 1 ) * REPLICATE_BLOCK_SIZE );
+        for( unsigned int r = block * REPLICATE_BLOCK_SIZE; r < last; r++ )
+        {
+          double sum_m = 0, sum_y = 0;
+          for( unsigned int c = 0; c < n; c++ )
+          {
+            unsigned int index = distribution( engine );
+            sum_m += this->selected_list[index];
+            sum_y += this->diseased_list[index];
+          }
+          estimate_list[r] = sum_y / sum_m;
+        }
+      }
+    };
+
+    if( 1 >= threads ) worker();
+    else
+    {
+      std::vector< std::thread > thread_list;
+      for( unsigned int t = 0; t < std::min( threads, blocks ); t++ )
+        thread_list.push_back( std::thread( worker ) );
+      for( auto it = thread_list.begin(); it != thread_list.end(); ++it ) it->join();
+    }
+
+    // replicates which happen to draw no selected individuals have no prevalence
+    double count = 0, mean = 0, squared_sum = 0;
+    for( auto it = estimate_list.cbegin(); it != estimate_list.cend(); ++it )
+    {
+      if( std::isnan( *it ) ) continue;
+      double diff = *it - mean;
+      count++;
+      mean += diff / count;
+      squared_sum += diff * ( *it - mean );
+    }
+    return 2 > count ? std::numeric_limits< double >::quiet_NaN() : squared_sum / ( count - 1 );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  double cluster_variance::get_design_effect() const
+  {
+    double proportion = this->get_proportion();
+    double srs_variance = proportion * ( 1 - proportion ) / this->get_total_selected();
+    if( !( 0 < srs_variance ) ) return std::numeric_limits< double >::quiet_NaN();
+    return this->get_ratio_variance() / srs_variance;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  double cluster_variance::get_intracluster_correlation() const
+  {
+    double mean_size = this->get_total_selected() / this->get_number_of_clusters();
+    if( !( 1 < mean_size ) ) return std::numeric_limits< double >::quiet_NaN();
+    return ( this->get_design_effect() - 1 ) / ( mean_size - 1 );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  double cluster_variance::get_effective_sample_size() const
+  {
+    return this->get_total_selected() / this->get_design_effect();
+  }
+}
@@ -0,0 +1,126 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   cluster_variance.h
+  Language: C++
+
+=========================================================================*/
+
+#ifndef __sampsim_cluster_variance_h
+#define __sampsim_cluster_variance_h
+
+#include <vector>
+
+/**
+ * @addtogroup sampsim
+ * @{
+ */
+
+namespace sampsim
+{
+  /**
+   * @class cluster_variance
+   * @author Patrick Emond <emondpd@mcmaster.ca>
+   * @brief Design-based variance estimates of a cluster sample's prevalence
+   * @details
+   * The prevalence of a cluster sample is the ratio of the total number of diseased individuals to the
+   * total number of selected individuals, summed over all clusters (towns).  Its variance can be
+   * estimated by linearisation (the ratio estimator), by deleting one cluster at a time (jackknife) or
+   * by resampling clusters with replacement (bootstrap).  Only the per-cluster counts are needed so
+   * estimates can be made long after the sampled population itself is gone.
+   */
+  class cluster_variance
+  {
+  public:
+    /**
+     * Removes all clusters
+     */
+    void clear();
+
+    /**
+     * Adds a cluster's number of selected and selected diseased individuals
+     */
+    void add_cluster( const double selected, const double diseased );
+
+    /**
+     * Returns the number of clusters which have been added
+     */
+    unsigned int get_number_of_clusters() const { return this->selected_list.size(); }
+
+    /**
+     * Returns the prevalence (total diseased over total selected)
+     */
+    double get_proportion() const;
+
+    /**
+     * Returns the ratio (linearisation) estimate of the prevalence's variance
+     *
+     * NaN is returned when there are fewer than two clusters.
+     */
+    double get_ratio_variance() const;
+
+    /**
+     * Returns the delete-one-cluster jackknife estimate of the prevalence's variance
+     *
+     * NaN is returned when there are fewer than two clusters.
+     */
+    double get_jackknife_variance() const;
+
+    /**
+     * Returns the bootstrap estimate of the prevalence's variance
+     *
+     * Clusters are drawn with replacement to create each replicate.  Replicates are divided into
+     * fixed-size blocks, each with its own random engine seeded by the seed and the block's index, so
+     * the result only depends on the seed and not on the number of threads or the global engine.
+     * NaN is returned when there are fewer than two clusters or replicates.
+     */
+    double get_bootstrap_variance(
+      const unsigned int replicates, const unsigned int seed, const unsigned int threads = 1 ) const;
+
+    /**
+     * Returns the design effect: the ratio variance over the variance of a simple random sample, p(1-p)/n,
+     * of the same total size
+     *
+     * NaN is returned when there are fewer than two clusters or the prevalence is 0 or 1.
+     */
+    double get_design_effect() const;
+
+    /**
+     * Returns the intra-cluster correlation implied by the design effect and the mean cluster size,
+     * (deff - 1) / (m - 1)
+     *
+     * NaN is returned when the design effect is undefined or the mean cluster size is not above one.
+     */
+    double get_intracluster_correlation() const;
+
+    /**
+     * Returns the effective sample size: the total number of selected individuals over the design effect
+     */
+    double get_effective_sample_size() const;
+
+  private:
+    /**
+     * Returns the total number of selected individuals in all clusters
+     */
+    double get_total_selected() const;
+
+    /**
+     * The number of bootstrap replicates drawn from each random engine
+     */
+    static const unsigned int REPLICATE_BLOCK_SIZE = 64;
+
+    /**
+     * The number of selected individuals in each cluster
+     */
+    std::vector< double > selected_list;
+
+    /**
+     * The number of selected diseased individuals in each cluster
+     */
+    std::vector< double > diseased_list;
+  };
+}
+
+/** @} end of doxygen group */
+
+#endif
@@ -8,6 +8,7 @@
 
 #include "coordinate.h"
 
+#include "csv_writer.h"
 #include "utilities.h"
 
 #include <cmath>
@@ -63,6 +64,13 @@ namespace sampsim
                      << std::fixed << this->get_r() << "," << this->get_a();
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void coordinate::to_csv( csv_writer &household_writer, csv_writer &individual_writer ) const
+  {
+    household_writer << csv_writer::fixed( this->x, 3 ) << ',' << csv_writer::fixed( this->y, 3 ) << ','
+                     << csv_writer::fixed( this->get_r(), 3 ) << ',' << csv_writer::fixed( this->get_a(), 3 );
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   double coordinate::distance( const coordinate c ) const
   {
@@ -22,6 +22,8 @@ namespace Json{ class Value; }
 
 namespace sampsim
 {
+  class csv_writer;
+
   /**
    * @class coordinate
    * @author Patrick Emond <emondpd@mcmaster.ca>
@@ -47,6 +49,13 @@ namespace sampsim
     void to_json( Json::Value& ) const;
     void to_csv( std::ostream&, std::ostream& ) const;
 
+    /**
+     * Output object to two CSV writers (households and individuals)
+     * 
+     * Coordinates are written to the household writer with three decimal places.
+     */
+    void to_csv( csv_writer&, csv_writer& ) const;
+
     /**
      * Comparison operator
      * 
@@ -0,0 +1,236 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   csv_writer.h
+  Language: C++
+
+=========================================================================*/
+
+#ifndef __sampsim_csv_writer_h
+#define __sampsim_csv_writer_h
+
+#include "utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+/**
+ * @addtogroup sampsim
+ * @{
+ */
+
+namespace sampsim
+{
+  /**
+   * @class csv_writer
+   * @author Patrick Emond <emondpd@mcmaster.ca>
+   * @brief A buffer used to quickly build CSV files
+   * @details
+   * Flat files of large populations contain tens of millions of values, so formatting them through
+   * std::ostream (with its locale and format state) takes up most of the time spent writing them.
+   * This class appends values directly to a string: integers are converted by hand, enums are written
+   * from precomputed literals and only floating point values are formatted using snprintf.  Doubles
+   * are written in the same format as a default std::ostream (6 significant digits) unless the
+   * fixed manipulator is used.  Nothing is ever flushed, once done the buffer's contents may be moved
+   * out of the writer by take().
+   */
+  class csv_writer
+  {
+  public:
+    /**
+     * @struct fixed
+     * @brief Writes a double using a fixed number of decimal places (like std::fixed)
+     */
+    struct fixed
+    {
+      /**
+       * Constructor
+       */
+      fixed( const double value, const int precision ) : value( value ), precision( precision ) {}
+
+      /**
+       * The value to write
+       */
+      double value;
+
+      /**
+       * The number of decimal places to write
+       */
+      int precision;
+    };
+
+    /**
+     * Constructor
+     */
+    csv_writer( const std::string::size_type capacity = 0 ) { this->buffer.reserve( capacity ); }
+
+    /**
+     * Returns a reference to the buffer's contents
+     */
+    const std::string& str() const { return this->buffer; }
+
+    /**
+     * Moves the buffer's contents out of the writer, leaving it empty
+     */
+    std::string take()
+    {
+      std::string result;
+      result.swap( this->buffer );
+      return result;
+    }
+
+    /**
+     * Returns the number of characters in the buffer
+     */
+    std::string::size_type size() const { return this->buffer.size(); }
+
+    /**
+     * Removes all characters from the buffer
+     */
+    void clear() { this->buffer.clear(); }
+
+    /**
+     * Appends the contents of another writer
+     */
+    csv_writer& operator<<( const csv_writer &writer )
+    {
+      this->buffer.append( writer.buffer );
+      return *this;
+    }
+
+    /**
+     * Appends a single character
+     */
+    csv_writer& operator<<( const char c )
+    {
+      this->buffer.push_back( c );
+      return *this;
+    }
+
+    /**
+     * Appends a string
+     */
+    csv_writer& operator<<( const char *str )
+    {
+      this->buffer.append( str );
+      return *this;
+    }
+
+    /**
+     * Appends a string
+     */
+    csv_writer& operator<<( const std::string &str )
+    {
+      this->buffer.append( str );
+      return *this;
+    }
+
+    /**
+     * Appends an unsigned integer
+     */
+    csv_writer& operator<<( unsigned long long value )
+    {
+      char digits[20];
+      int length = 0;
+      do
+      {
+        digits[length++] = '0' + value % 10;
+        value /= 10;
+      } while( 0 < value );
+      while( 0 < length ) this->buffer.push_back( digits[--length] );
+      return *this;
+    }
+
+    /**
+     * Appends an unsigned integer
+     */
+    csv_writer& operator<<( const unsigned long value )
+    { return *this << static_cast< unsigned long long >( value ); }
+
+    /**
+     * Appends an unsigned integer
+     */
+    csv_writer& operator<<( const unsigned int value )
+    { return *this << static_cast< unsigned long long >( value ); }
+
+    /**
+     * Appends a signed integer
+     */
+    csv_writer& operator<<( const long long value )
+    {
+      if( 0 > value )
+      {
+        this->buffer.push_back( '-' );
+        return *this << ( ~static_cast< unsigned long long >( value ) + 1 );
+      }
+      return *this << static_cast< unsigned long long >( value );
+    }
+
+    /**
+     * Appends a signed integer
+     */
+    csv_writer& operator<<( const long value ) { return *this << static_cast< long long >( value ); }
+
+    /**
+     * Appends a signed integer
+     */
+    csv_writer& operator<<( const int value ) { return *this << static_cast< long long >( value ); }
+
+    /**
+     * Appends a double using 6 significant digits (the same as std::ostream's default)
+     */
+    csv_writer& operator<<( const double value )
+    {
+      // integers which %g would write without an exponent can be converted by hand
+      if( -1e6 < value && value < 1e6 && value == static_cast< long long >( value ) &&
+          !( 0 == value && std::signbit( value ) ) )
+        return *this << static_cast< long long >( value );
+
+      char str[32];
+      int length = snprintf( str, sizeof( str ), "%g", value );
+      this->buffer.append( str, length );
+      return *this;
+    }
+
+    /**
+     * Appends a double using a fixed number of decimal places
+     */
+    csv_writer& operator<<( const fixed &f )
+    {
+      char str[352]; // enough for the largest double in fixed notation
+      int length = snprintf( str, sizeof( str ), "%.*f", f.precision, f.value );
+      this->buffer.append( str, std::min( length, static_cast< int >( sizeof( str ) ) - 1 ) );
+      return *this;
+    }
+
+    /**
+     * Appends the name of an age type
+     */
+    csv_writer& operator<<( const age_type type )
+    {
+      static const char *literal[] = { "unknown", "either", "adult", "child" };
+      return *this << literal[type];
+    }
+
+    /**
+     * Appends the name of a sex type
+     */
+    csv_writer& operator<<( const sex_type type )
+    {
+      static const char *literal[] = { "unknown", "either", "female", "male" };
+      return *this << literal[type];
+    }
+
+  protected:
+    /**
+     * The CSV data written so far
+     */
+    std::string buffer;
+  };
+}
+
+/** @} end of doxygen group */
+
+#endif
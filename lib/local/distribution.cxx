@@ -13,6 +13,7 @@
 #include <json/value.h>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 namespace sampsim
 {
@@ -44,7 +45,7 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void distribution::set_lognormal( const double mean, const double sd )
   {
-    this->debug( "set_lognormal( mean = %f, sd = %f )", mean, sd );
+    SAMPSIM_TRACE( "set_lognormal( mean = %f, sd = %f )", mean, sd );
     this->distribution_type = distribution::LOGNORMAL;
     this->lognormal = std::lognormal_distribution<double>( mean, sd );
   }
@@ -52,7 +53,7 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void distribution::set_normal( const double mean, const double sd )
   {
-    this->debug( "set_normal( mean = %f, sd = %f )", mean, sd );
+    SAMPSIM_TRACE( "set_normal( mean = %f, sd = %f )", mean, sd );
     this->distribution_type = distribution::NORMAL;
     this->normal = std::normal_distribution<double>( mean, sd );
   }
@@ -60,7 +61,7 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void distribution::set_pareto( const double b, const double a, const double max )
   {
-    this->debug( "set_pareto( b = %f, a = %f, max = %f )", b, a, max );
+    SAMPSIM_TRACE( "set_pareto( b = %f, a = %f, max = %f )", b, a, max );
     this->distribution_type = distribution::PARETO;
     this->pareto = sampsim::pareto( b, a, max );
   }
@@ -68,7 +69,7 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void distribution::set_poisson( const double mean )
   {
-    this->debug( "set_poisson( mean = %f )", mean );
+    SAMPSIM_TRACE( "set_poisson( mean = %f )", mean );
     this->distribution_type = distribution::POISSON;
     this->poisson = std::poisson_distribution<int>( mean );
   }
@@ -76,7 +77,7 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void distribution::set_weibull( const double a, const double b )
   {
-    this->debug( "set_weibull( a = %f, b = %f )", a, b );
+    SAMPSIM_TRACE( "set_weibull( a = %f, b = %f )", a, b );
     this->distribution_type = distribution::WEIBULL;
     this->weibull = std::weibull_distribution<double>( a, b );
   }
@@ -98,6 +99,50 @@ namespace sampsim
     throw std::runtime_error( "Cannot generate value using unknown distribution" );
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void distribution::generate_values( const std::size_t count, double *values )
+  {
+    std::mt19937 &engine = utilities::random_engine;
+    if( distribution::LOGNORMAL == this->distribution_type )
+      for( std::size_t i = 0; i < count; i++ ) values[i] = this->lognormal( engine );
+    else if( distribution::NORMAL == this->distribution_type )
+      for( std::size_t i = 0; i < count; i++ ) values[i] = this->normal( engine );
+    else if( distribution::PARETO == this->distribution_type )
+      for( std::size_t i = 0; i < count; i++ ) values[i] = this->pareto( engine );
+    else if( distribution::POISSON == this->distribution_type )
+      for( std::size_t i = 0; i < count; i++ ) values[i] = static_cast<double>( this->poisson( engine ) );
+    else if( distribution::WEIBULL == this->distribution_type )
+      for( std::size_t i = 0; i < count; i++ ) values[i] = this->weibull( engine );
+    else throw std::runtime_error( "Cannot generate values using unknown distribution" );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void distribution::generate_values( const std::size_t count, int *values )
+  {
+    if( distribution::POISSON == this->distribution_type )
+    {
+      for( std::size_t i = 0; i < count; i++ ) values[i] = this->poisson( utilities::random_engine );
+    }
+    else
+    {
+      std::vector< double > value_list( count );
+      this->generate_values( count, value_list.data() );
+      for( std::size_t i = 0; i < count; i++ ) values[i] = static_cast<int>( value_list[i] );
+    }
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void distribution::generate_independent_normal_values( const std::size_t count, double *values )
+  {
+    std::normal_distribution<double> standard;
+    for( std::size_t i = 0; i < count; i++ )
+    {
+      // discard the second value of the previous pair, as a new distribution would
+      standard.reset();
+      values[i] = standard( utilities::random_engine );
+    }
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   std::string distribution::to_string()
   {
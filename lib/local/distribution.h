@@ -142,6 +142,31 @@ namespace sampsim
      */
     double generate_value();
 
+    /**
+     * Fills an array with random values conforming to the distribution's current type
+     * 
+     * The values are identical to those returned by calling generate_value() the same number of
+     * times, but the distribution's type is only checked once.
+     */
+    void generate_values( const std::size_t count, double *values );
+
+    /**
+     * Fills an array with random integer values conforming to the distribution's current type
+     * 
+     * Poisson values are returned as drawn, all other types are truncated to an integer.
+     */
+    void generate_values( const std::size_t count, int *values );
+
+    /**
+     * Fills an array with standard normal values, each drawn by a newly constructed distribution
+     * 
+     * Normal distributions produce values in pairs and keep the second for the next call, so this
+     * does not give the same values as repeated calls to a single normal distribution's
+     * generate_value().  It does match drawing one value from a new normal or log-normal
+     * distribution at a time: such a value is mean + sd * z or exp( mean + sd * z ) respectively.
+     */
+    static void generate_independent_normal_values( const std::size_t count, double *values );
+
     /**
      * Returns the trend as a string representation
      */
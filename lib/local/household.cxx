@@ -9,6 +9,7 @@
 #include "household.h"
 
 #include "building.h"
+#include "csv_writer.h"
 #include "household.h"
 #include "individual.h"
 #include "population.h"
@@ -17,6 +18,8 @@
 #include "trend.h"
 #include "utilities.h"
 
+#include <algorithm>
+#include <cmath>
 #include <json/value.h>
 #include <stdexcept>
 
@@ -26,6 +29,7 @@ namespace sampsim
   household::household( building *parent )
   {
     this->parent = parent;
+    std::fill( &( this->member_count[0][0] ), &( this->member_count[0][0] ) + 9, 0 );
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -57,76 +61,82 @@ namespace sampsim
     return NULL == this->parent ? NULL : this->parent->get_population();
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void household::draw_members( town *town, std::vector< sex_type > &sex_list )
+  {
+    // We'll use 1 + distribution so that there are no empty households
+    int size = town->get_population_distribution()->generate_value() + 1;
+    sex_list.resize( size );
+
+    // the first individual is an adult of random sex, the second an adult of the opposite sex and
+    // the rest are children of random sex
+    bool male = 0 == utilities::random( 0, 1 );
+    sex_list[0] = male ? MALE : FEMALE;
+    if( 1 < size ) sex_list[1] = !male ? MALE : FEMALE;
+    for( int c = 2; c < size; c++ ) sex_list[c] = 0 == utilities::random( 0, 1 ) ? MALE : FEMALE;
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void household::create()
   {
     // make sure the household has a parent
     if( NULL == this->parent ) throw std::runtime_error( "Tried to create an orphaned household" );
 
-    this->index = this->get_population()->add_household( this );
+    std::vector< sex_type > sex_list;
+    household::draw_members( this->get_town(), sex_list );
+    this->create( sex_list.size(), sex_list.data() );
+  }
 
-    // We'll use 1 + distribution so that there are no empty households
-    int size = this->get_town()->get_population_distribution()->generate_value() + 1;
-    this->individual_list.reserve( size );
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void household::create( const std::vector< sex_type >::size_type size, const sex_type *sex_list )
+  {
+    // make sure the household has a parent
+    if( NULL == this->parent ) throw std::runtime_error( "Tried to create an orphaned household" );
 
-    // create the first individual an adult of random sex
-    bool male = 0 == utilities::random( 0, 1 );
-    individual *i = new individual( this );
-    i->create();
-    i->set_age( ADULT );
-    i->set_sex( male ? MALE : FEMALE );
-    this->individual_list.push_back( i );
-
-    // now make the rest of the members of this household
-    for( int c = 1; c < size; c++ )
+    population *pop = this->get_population();
+    this->index = pop->add_household( this );
+
+    this->individual_list.reserve( size );
+    for( std::vector< sex_type >::size_type c = 0; c < size; c++ )
     {
       individual *i = new individual( this );
       i->create();
-
-      if( 1 == c )
-      { // the first must be an adult of opposite sex of the first
-        i->set_sex( !male ? MALE : FEMALE );
-        i->set_age( ADULT );
-      }
-      else
-      { // the rest are children of random sex
-        i->set_sex( 0 == utilities::random( 0, 1 ) ? MALE : FEMALE );
-        i->set_age( CHILD );
-      }
-
+      i->set_age( 2 > c ? ADULT : CHILD );
+      i->set_sex( sex_list[c] );
       this->individual_list.push_back( i );
     }
+    this->count_members();
 
-    this->get_population()->expire_summary();
+    pop->expire_summary();
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void household::define()
+  {
+    double trend_values[trend_field::NUMBER_OF_FIELDS];
+    this->get_town()->get_trend_field()->evaluate( this->get_building()->get_position(), trend_values );
+    double normal_values[3];
+    distribution::generate_independent_normal_values( 3, normal_values );
+    this->define( normal_values, trend_values );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void household::define( const double *normal_values, const double *trend_values )
   {
     for( auto it = this->individual_list.begin(); it != this->individual_list.end(); ++it ) (*it)->define();
 
-    town *town = this->get_town();
-
-    distribution income_distribution;
-    income_distribution.set_lognormal(
-      town->get_mean_income()->get_value( this->get_building()->get_position() ),
-      town->get_sd_income()->get_value( this->get_building()->get_position() ) );
-    this->income = income_distribution.generate_value();
-    this->debug( "setting income to %f", this->income );
-
-    distribution disease_risk_distribution;
-    disease_risk_distribution.set_normal(
-      town->get_mean_disease()->get_value( this->get_building()->get_position() ),
-      town->get_sd_disease()->get_value( this->get_building()->get_position() ) );
-    this->disease_risk = disease_risk_distribution.generate_value();
-    this->debug( "setting disease risk to %f", this->disease_risk );
-
-    distribution exposure_risk_distribution;
-    exposure_risk_distribution.set_normal(
-      town->get_mean_exposure()->get_value( this->get_building()->get_position() ),
-      town->get_sd_exposure()->get_value( this->get_building()->get_position() ) );
-    this->exposure_risk = exposure_risk_distribution.generate_value();
-    this->debug( "setting exposure risk to %f", this->exposure_risk );
+    // income is log-normal and both risks are normal, all with parameters which vary by position
+    this->income = exp(
+      normal_values[0] * trend_values[trend_field::SD_INCOME] + trend_values[trend_field::MEAN_INCOME] );
+    SAMPSIM_TRACE( "setting income to %f", this->income );
+
+    this->disease_risk =
+      normal_values[1] * trend_values[trend_field::SD_DISEASE] + trend_values[trend_field::MEAN_DISEASE];
+    SAMPSIM_TRACE( "setting disease risk to %f", this->disease_risk );
+
+    this->exposure_risk =
+      normal_values[2] * trend_values[trend_field::SD_EXPOSURE] + trend_values[trend_field::MEAN_EXPOSURE];
+    SAMPSIM_TRACE( "setting exposure risk to %f", this->exposure_risk );
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -146,6 +156,7 @@ namespace sampsim
       i->from_json( json["individual_list"][c] );
       this->individual_list.push_back( i );
     }
+    this->count_members();
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -175,35 +186,43 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void household::to_csv( std::ostream &household_stream, std::ostream &individual_stream ) const
   {
-    population *population = this->get_population();
+    csv_writer household_writer, individual_writer;
+    this->to_csv( household_writer, individual_writer );
+    household_stream << household_writer.str();
+    individual_stream << individual_writer.str();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void household::to_csv( csv_writer &household_writer, csv_writer &individual_writer ) const
+  {
     unsigned int town_index = this->get_town()->get_index();
 
-    // write the household index and position to the household stream
-    household_stream << town_index << "," << this->index << ",";
-    this->get_building()->get_position().to_csv( household_stream, individual_stream );
-    household_stream << "," << this->individual_list.size()
-                     << "," << this->income << ","
-                     << this->disease_risk << ","
-                     << this->exposure_risk;
+    // write the household index and position to the household writer
+    household_writer << town_index << ',' << this->index << ',';
+    this->get_building()->get_position().to_csv( household_writer, individual_writer );
+    household_writer << ',' << this->individual_list.size()
+                     << ',' << csv_writer::fixed( this->income, 3 )
+                     << ',' << csv_writer::fixed( this->disease_risk, 3 )
+                     << ',' << csv_writer::fixed( this->exposure_risk, 3 );
 
-    // write all individuals in this household to the individual stream
-    bool disease[] = { false, false, false, false };
+    // write all individuals in this household to the individual writer
+    bool disease[SAMPSIM_MAXIMUM_RR] = { false };
     bool sample_mode = this->get_population()->get_sample_mode();
     for( auto it = this->individual_list.begin(); it != this->individual_list.end(); ++it )
     {
       individual *i = *it;
       if( !sample_mode || i->is_selected() )
       {
-        individual_stream << town_index << "," << this->index << ",";
+        individual_writer << town_index << ',' << this->index << ',';
         for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) if( !disease[rr] ) disease[rr] = i->is_disease(rr);
-        i->to_csv( household_stream, individual_stream );
-        individual_stream << std::endl;
+        i->to_csv( household_writer, individual_writer );
+        individual_writer << '\n';
       }
     }
 
-    // finish writing the household stream
-    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) household_stream << "," << ( disease[rr] ? "1" : "0" );
-    household_stream << std::endl;
+    // finish writing the household writer
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) household_writer << ',' << ( disease[rr] ? '1' : '0' );
+    household_writer << '\n';
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -221,12 +240,12 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void household::rebuild_summary()
   {
-    this->sum.reset();
-    for( auto it = this->individual_list.begin(); it != this->individual_list.end(); ++it )
-    {
-      (*it)->rebuild_summary();
-      this->sum.add( (*it) );
-    }
+    summary *sum = this->reset_summary();
+    population *pop = this->get_population();
+    bool sample_mode = pop->get_sample_mode();
+    bool use_sample_weights = pop->get_use_sample_weights();
+    for( auto it = this->individual_list.cbegin(); it != this->individual_list.cend(); ++it )
+      (*it)->add_to_summary( sum, sample_mode, use_sample_weights );
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -253,6 +272,8 @@ namespace sampsim
     this->disease_risk = object->disease_risk;
     this->exposure_risk = object->exposure_risk;
     this->selected = object->selected;
+    std::copy(
+      &( object->member_count[0][0] ), &( object->member_count[0][0] ) + 9, &( this->member_count[0][0] ) );
     this->get_population()->add_household( this, this->index );
 
     // delete all individuals
@@ -276,4 +297,20 @@ namespace sampsim
   {
     for( auto it = this->individual_list.cbegin(); it != this->individual_list.cend(); ++it ) (*it)->select();
   }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void household::count_members()
+  {
+    std::fill( &( this->member_count[0][0] ), &( this->member_count[0][0] ) + 9, 0 );
+    for( auto it = this->individual_list.cbegin(); it != this->individual_list.cend(); ++it )
+    {
+      // every member counts towards any age and sex as well as its own age and sex (when known)
+      unsigned int age = ANY_AGE < (*it)->get_age() ? (*it)->get_age() - ANY_AGE : 0;
+      unsigned int sex = ANY_SEX < (*it)->get_sex() ? (*it)->get_sex() - ANY_SEX : 0;
+      this->member_count[0][0]++;
+      if( 0 < age ) this->member_count[age][0]++;
+      if( 0 < sex ) this->member_count[0][sex]++;
+      if( 0 < age && 0 < sex ) this->member_count[age][sex]++;
+    }
+  }
 }
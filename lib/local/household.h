@@ -22,6 +22,7 @@ namespace Json { class Value; }
 namespace sampsim
 {
   class building;
+  class csv_writer;
   class individual;
   class population;
   class town;
@@ -80,6 +81,11 @@ namespace sampsim
     void unselect();
     void select_all();
 
+    /**
+     * Output object to two CSV writers (households and individuals)
+     */
+    void to_csv( csv_writer&, csv_writer& ) const;
+
     /**
      * Iterator access to child individuals
      * 
@@ -152,11 +158,48 @@ namespace sampsim
      */
     unsigned int get_index() const { return this->index; }
 
+    /**
+     * Returns the number of the household's members of the given age and sex (ANY_AGE and ANY_SEX match all)
+     * 
+     * Members are counted when they are created or read, so unlike the household's summary every member is
+     * included whether or not it is selected.  Sampled copies of a household keep the counts of the original.
+     */
+    unsigned int get_number_of_members( const age_type age, const sex_type sex ) const
+    { return this->member_count[age - ANY_AGE][sex - ANY_SEX]; }
+
+    /**
+     * Draws the size and member sexes of a new household in the given town
+     * 
+     * The first two members are adults of opposite sex and the rest are children.  This draws the
+     * same random values, in the same order, as create() does.
+     */
+    static void draw_members( town*, std::vector< sex_type > &sex_list );
+
   protected:
     void create();
     void define();
 
+    /**
+     * Creates the household's members using sexes provided by draw_members()
+     */
+    void create( const std::vector< sex_type >::size_type size, const sex_type *sex_list );
+
+    /**
+     * Defines the household using three pre-drawn standard normal values and its town's trends
+     * 
+     * The normal values are used, in order, for the household's income, disease risk and exposure
+     * risk.  They are expected to come from distribution::generate_independent_normal_values() so that
+     * the result is the same as calling define().  The trend values are those of the town's trend field
+     * at the household's position (see trend_field::evaluate()).
+     */
+    void define( const double *normal_values, const double *trend_values );
+
   private:
+    /**
+     * Counts the household's members by age and sex, see get_number_of_members()
+     */
+    void count_members();
+
     /**
      * A reference to the building that the household belongs to (not reference counted)
      */
@@ -182,6 +225,11 @@ namespace sampsim
      */
     double exposure_risk;
 
+    /**
+     * The number of members indexed by age (any, adult, child) and sex (any, female, male)
+     */
+    unsigned short member_count[3][3];
+
     /**
      * A container holding all individuals belonging to this household.  The household is responsible
      * for managing the memory needed for all of its child individuals.
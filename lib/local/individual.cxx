@@ -8,6 +8,7 @@
 
 #include "individual.h"
 
+#include "csv_writer.h"
 #include "household.h"
 #include "population.h"
 #include "summary.h"
@@ -23,7 +24,7 @@ namespace sampsim
     this->parent = parent;
     this->age = UNKNOWN_AGE_TYPE;
     this->sex = UNKNOWN_SEX_TYPE;
-    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) this->state_list.push_back( UNKNOWN_STATE_TYPE );
+    this->disease_mask = 0;
     this->exposure = UNKNOWN_EXPOSURE_TYPE;
     this->sample_weight = 1.0;
   }
@@ -42,8 +43,7 @@ namespace sampsim
     this->selected = i->selected;
     this->age = i->age;
     this->sex = i->sex;
-    this->state_list.clear();
-    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) this->state_list.push_back( i->state_list[rr] );
+    this->disease_mask = i->disease_mask;
     this->exposure = i->exposure;
     this->sample_weight = i->sample_weight;
     this->get_population()->add_individual( this, this->index );
@@ -93,9 +93,11 @@ namespace sampsim
     this->index = json["index"].asUInt();
     this->age = sampsim::get_age_type( json["age"].asString() );
     this->sex = sampsim::get_sex_type( json["sex"].asString() );
-    this->state_list.resize( utilities::rr.size() );
+    if( json["disease"].size() != utilities::rr.size() )
+      throw std::runtime_error( "Tried to read an individual with a different number of relative risks" );
+    this->disease_mask = 0;
     for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
-      this->state_list[rr] = 1 == json["disease"][rr].asUInt() ? DISEASED : HEALTHY;
+      if( 1 == json["disease"][rr].asUInt() ) this->disease_mask |= 1u << rr;
     this->exposure = 1 == json["exposed"].asUInt() ? EXPOSED : NOT_EXPOSED;
     this->sample_weight = pop->get_use_sample_weights() ? json["sample_weight"].asDouble() : 1.0;
     pop->add_individual( this, this->index );
@@ -112,43 +114,53 @@ namespace sampsim
     json["disease"] = Json::Value( Json::arrayValue );
     json["disease"].resize( utilities::rr.size() );
     for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
-      json["disease"][rr] = DISEASED == this->state_list[rr] ? 1 : 0;
+      json["disease"][rr] = this->is_disease( rr ) ? 1 : 0;
     if( this->get_population()->get_use_sample_weights() ) json["sample_weight"] = this->sample_weight;
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void individual::to_csv( std::ostream &household_stream, std::ostream &individual_stream ) const
   {
-    individual_stream << this->index << ","
-                      << sampsim::get_age_type_name( this->age ) << ","
-                      << sampsim::get_sex_type_name( this->sex ) << ","
-                      << ( EXPOSED == this->exposure ? 1 : 0 );
+    csv_writer household_writer, individual_writer;
+    this->to_csv( household_writer, individual_writer );
+    household_stream << household_writer.str();
+    individual_stream << individual_writer.str();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void individual::to_csv( csv_writer &household_writer, csv_writer &individual_writer ) const
+  {
+    individual_writer << this->index << ',' << this->age << ',' << this->sex << ','
+                      << ( EXPOSED == this->exposure ? '1' : '0' );
     for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
-      individual_stream << "," << ( DISEASED == this->state_list[rr] ? 1 : 0 );
-    if( this->get_population()->get_use_sample_weights() ) individual_stream << "," << this->sample_weight;
+      individual_writer << ',' << ( this->is_disease( rr ) ? '1' : '0' );
+    if( this->get_population()->get_use_sample_weights() ) individual_writer << ',' << this->sample_weight;
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void individual::assert_summary()
   {
-    this->get_population()->assert_summary();
+    // individuals don't keep their summary so it is rebuilt every time it is requested
+    this->rebuild_summary();
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void individual::rebuild_summary()
   {
-    this->sum.reset();
+    population *pop = this->get_population();
+    this->add_to_summary( this->reset_summary(), pop->get_sample_mode(), pop->get_use_sample_weights() );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void individual::add_to_summary( summary *sum, const bool sample_mode, const bool use_sample_weights ) const
+  {
+    if( sample_mode && !this->is_selected() ) return;
 
-    if( !this->get_population()->get_sample_mode() || this->is_selected() )
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
     {
-      int index;
-      for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
-      {
-        index = summary::get_count_index( this->get_age(), this->get_sex(), this->state_list[rr], this->exposure );
-        this->sum.count[rr][index]++;
-        if( this->get_population()->get_use_sample_weights() )
-          this->sum.weighted_count[rr][index] += this->sample_weight;
-      }
+      int index = summary::get_count_index( this->age, this->sex, this->get_state( rr ), this->exposure );
+      sum->count[rr][index]++;
+      if( use_sample_weights ) sum->weighted_count[rr][index] += this->sample_weight;
     }
   }
 
@@ -23,6 +23,7 @@ namespace Json { class Value; }
 namespace sampsim
 {
   class building;
+  class csv_writer;
   class household;
   class population;
   class town;
@@ -78,6 +79,19 @@ namespace sampsim
     double get_sample_weight() const { return this->sample_weight; }
     void set_sample_weight( const double sample_weight ) { this->sample_weight = sample_weight; }
 
+    /**
+     * Output object to two CSV writers (households and individuals)
+     */
+    void to_csv( csv_writer&, csv_writer& ) const;
+
+    /**
+     * Adds the individual to a summary
+     * 
+     * Households add their individuals directly to their own summary instead of building a summary for
+     * every individual.  Individuals who are not selected are skipped when in sample mode.
+     */
+    void add_to_summary( summary *sum, const bool sample_mode, const bool use_sample_weights ) const;
+
     /**
      * Returns the individual's parent household
      */
@@ -126,20 +140,21 @@ namespace sampsim
     /**
      * Returns the individual's state
      */
-    state_type get_state( unsigned int index ) const { return this->state_list[index]; }
+    state_type get_state( unsigned int index ) const { return this->is_disease( index ) ? DISEASED : HEALTHY; }
 
     /**
      * Sets the individual's disease status
      */
     void set_disease( unsigned int index, const bool disease )
     {
-      this->state_list[index] = disease ? DISEASED : HEALTHY;
+      if( disease ) this->disease_mask |= 1u << index;
+      else this->disease_mask &= ~( 1u << index );
     }
 
     /**
      * Returns whether the individual has a disease
      */
-    bool is_disease( unsigned int index ) const { return DISEASED == this->state_list[index]; }
+    bool is_disease( unsigned int index ) const { return this->disease_mask & ( 1u << index ); }
 
     /**
      * Returns the individual's exposure
@@ -187,9 +202,9 @@ namespace sampsim
     sex_type sex;
 
     /**
-     * The individual's disease status
+     * The individual's disease status (one bit per rr)
      */
-    std::vector<state_type> state_list;
+    unsigned int disease_mask;
 
     /**
      * The individual's exposure status
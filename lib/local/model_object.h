@@ -48,7 +48,12 @@ namespace sampsim
     /**
      * Constructor
      */
-    model_object() : selected( false ) {}
+    model_object() : selected( false ), sum( NULL ) {}
+
+    /**
+     * Destructor
+     */
+    ~model_object() { utilities::safe_delete( this->sum ); }
 
     /**
      * Get the number of individuals in the model
@@ -75,7 +80,7 @@ namespace sampsim
      * This method iterates over all child models every time it is called, so it should only be used when
      * re-counting is necessary.  Do not call this method until the create() method has been called.
      */
-    virtual summary* get_summary() { this->assert_summary(); return &(this->sum); }
+    virtual summary* get_summary() { this->assert_summary(); return this->sum; }
 
     /**
      * Returns whether the model is selected or not
@@ -134,6 +139,16 @@ namespace sampsim
      */
     virtual void rebuild_summary() = 0;
 
+    /**
+     * Empties the object's summary, creating it first if it doesn't exist yet, and returns it
+     */
+    summary* reset_summary()
+    {
+      if( NULL == this->sum ) this->sum = new summary;
+      else this->sum->reset();
+      return this->sum;
+    }
+
     /**
      * Whether the model is selected
      */
@@ -141,8 +156,17 @@ namespace sampsim
 
     /**
      * A summary object which tracks a summary of the object's data
+     * 
+     * Only populations, towns and households keep their summary up to date.  Tiles, buildings and
+     * individuals are far more numerous and their summaries are rarely needed, so they are only created
+     * (and rebuilt from their households or packed data) when get_summary() is called.
      */
-    summary sum;
+    summary *sum;
+
+  private:
+    // the summary is owned by the object so it must not be copied
+    model_object( const model_object& );
+    model_object& operator=( const model_object& );
   };
 }
 
@@ -0,0 +1,163 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   pocket_field.cxx
+  Language: C++
+
+=========================================================================*/
+
+#include "pocket_field.h"
+
+#include "coordinate.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace sampsim
+{
+  namespace
+  {
+    // the kernels, each applied to a distance which has already been scaled
+    struct exponential_kernel
+    {
+      static double apply( const double distance ) { return exp( -distance ); }
+    };
+
+    struct inverse_square_kernel
+    {
+      static double apply( const double distance ) { return 1 / ( distance * distance ); }
+    };
+
+    struct gaussian_kernel
+    {
+      static double apply( const double distance ) { return exp( -( distance * distance ) ); }
+    };
+
+    // the number of pockets whose distances are determined before their kernels are applied
+    const unsigned int block_size = 64;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  pocket_field::pocket_field()
+  {
+    this->accumulator = &pocket_field::accumulate< exponential_kernel >;
+    this->scaling = 1.0;
+    this->cutoff = 0.0;
+    this->cell_size = 0.0;
+    this->cell_min = this->cell_max = std::pair< int, int >( 0, 0 );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void pocket_field::set_pockets(
+    const std::vector< coordinate > &pocket_list,
+    const std::string kernel,
+    const double scaling,
+    const double cutoff )
+  {
+    pocket_field::kernel_type type = pocket_field::get_kernel_type( kernel );
+    if( EXPONENTIAL == type ) this->accumulator = &pocket_field::accumulate< exponential_kernel >;
+    else if( INVERSE_SQUARE == type ) this->accumulator = &pocket_field::accumulate< inverse_square_kernel >;
+    else if( GAUSSIAN == type ) this->accumulator = &pocket_field::accumulate< gaussian_kernel >;
+    else
+    {
+      std::stringstream stream;
+      stream << "Using unknown disease pocket kernel type \"" << kernel << "\"";
+      throw std::runtime_error( stream.str() );
+    }
+
+    if( 0 > cutoff ) throw std::runtime_error( "Tried to set a negative disease pocket cutoff" );
+
+    this->scaling = scaling;
+    this->cutoff = cutoff;
+    this->cell_size = cutoff * scaling;
+    this->pocket_x.clear();
+    this->pocket_y.clear();
+    this->grid.clear();
+    this->cell_min = this->cell_max = std::pair< int, int >( 0, 0 );
+    for( auto it = pocket_list.cbegin(); it != pocket_list.cend(); ++it )
+    {
+      this->pocket_x.push_back( it->x );
+      this->pocket_y.push_back( it->y );
+      if( 0 < this->cell_size )
+      {
+        std::pair< int, int > cell( floor( it->x / this->cell_size ), floor( it->y / this->cell_size ) );
+        this->grid[cell].push_back( this->pocket_x.size() - 1 );
+        if( 1 == this->pocket_x.size() ) this->cell_min = this->cell_max = cell;
+        this->cell_min.first = std::min( this->cell_min.first, cell.first );
+        this->cell_min.second = std::min( this->cell_min.second, cell.second );
+        this->cell_max.first = std::max( this->cell_max.first, cell.first );
+        this->cell_max.second = std::max( this->cell_max.second, cell.second );
+      }
+    }
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  template< class kernel > double pocket_field::accumulate( const coordinate &position ) const
+  {
+    double factor = 0.0;
+    double distance[block_size];
+
+    // only pockets in this and the neighbouring cells may be within the cutoff
+    int x = 0, y = 0;
+    bool use_grid = 0 < this->cutoff;
+    if( use_grid )
+    {
+      x = floor( position.x / this->cell_size );
+      y = floor( position.y / this->cell_size );
+
+      // when the neighbouring cells include all pockets it is faster to visit them in order
+      use_grid = x - 1 > this->cell_min.first || x + 1 < this->cell_max.first ||
+                 y - 1 > this->cell_min.second || y + 1 < this->cell_max.second;
+    }
+
+    if( !use_grid )
+    {
+      // distances are calculated as coordinate::distance() does so that results are identical
+      const std::size_t size = this->pocket_x.size();
+      for( std::size_t start = 0; start < size; start += block_size )
+      {
+        const std::size_t count = std::min( static_cast< std::size_t >( block_size ), size - start );
+        for( std::size_t i = 0; i < count; i++ )
+        {
+          double dx = safe_subtract( position.x, this->pocket_x[start + i] );
+          double dy = safe_subtract( position.y, this->pocket_y[start + i] );
+          distance[i] = sqrt( dx*dx + dy*dy ) / this->scaling;
+        }
+
+        if( 0 == this->cutoff )
+        {
+          for( std::size_t i = 0; i < count; i++ ) factor += kernel::apply( distance[i] );
+        }
+        else
+        {
+          for( std::size_t i = 0; i < count; i++ )
+            if( distance[i] <= this->cutoff ) factor += kernel::apply( distance[i] );
+        }
+      }
+    }
+    else
+    {
+      for( int j = y - 1; j <= y + 1; j++ )
+      {
+        for( int i = x - 1; i <= x + 1; i++ )
+        {
+          auto cell_it = this->grid.find( std::pair< int, int >( i, j ) );
+          if( this->grid.cend() == cell_it ) continue;
+
+          for( auto it = cell_it->second.cbegin(); it != cell_it->second.cend(); ++it )
+          {
+            double dx = safe_subtract( position.x, this->pocket_x[*it] );
+            double dy = safe_subtract( position.y, this->pocket_y[*it] );
+            double d = sqrt( dx*dx + dy*dy ) / this->scaling;
+            if( d <= this->cutoff ) factor += kernel::apply( d );
+          }
+        }
+      }
+    }
+
+    return factor;
+  }
+}
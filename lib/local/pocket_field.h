@@ -0,0 +1,141 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   pocket_field.h
+  Language: C++
+
+=========================================================================*/
+
+#ifndef __sampsim_pocket_field_h
+#define __sampsim_pocket_field_h
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @addtogroup sampsim
+ * @{
+ */
+
+namespace sampsim
+{
+  class coordinate;
+
+  /**
+   * @class pocket_field
+   * @author Patrick Emond <emondpd@mcmaster.ca>
+   * @brief The combined influence of a town's disease pockets
+   * @details
+   * Every building's pocket factor is the sum of a kernel function of its (scaled) distance from
+   * each of its town's disease pockets.  The kernel is chosen once, when the pockets are set, and
+   * each kernel type has its own specialised accumulator so that no per-pocket decisions are made.
+   *
+   * An optional cutoff, expressed as a number of scaling distances, can be provided.  Pockets further
+   * than the cutoff are then ignored and pockets are stored in a grid of cells the size of the
+   * cutoff so that only nearby pockets are visited.  This makes the cost of a town with many pockets
+   * roughly linear in its number of buildings rather than in buildings times pockets.  Without a
+   * cutoff, or with a cutoff larger than the town, the result is identical to summing over every
+   * pocket in order.
+   */
+  class pocket_field
+  {
+  public:
+    /**
+     * A list of all supported kernel types
+     */
+    enum kernel_type
+    {
+      UNKNOWN = 0,
+      EXPONENTIAL,
+      INVERSE_SQUARE,
+      GAUSSIAN
+    };
+
+    /**
+     * Converts a string representation of a kernel to a type code
+     */
+    inline static pocket_field::kernel_type get_kernel_type( const std::string name )
+    {
+      if( "exponential" == name ) return EXPONENTIAL;
+      else if( "inverse_square" == name ) return INVERSE_SQUARE;
+      else if( "gaussian" == name ) return GAUSSIAN;
+      return UNKNOWN;
+    }
+
+    /**
+     * Constructor
+     */
+    pocket_field();
+
+    /**
+     * Sets the disease pockets, the kernel used by each pocket, the distance scaling and cutoff
+     *
+     * A cutoff of 0 means that every pocket contributes to every position.
+     */
+    void set_pockets(
+      const std::vector< coordinate > &pocket_list,
+      const std::string kernel,
+      const double scaling,
+      const double cutoff = 0.0 );
+
+    /**
+     * Returns the number of pockets in the field
+     */
+    std::size_t get_number_of_pockets() const { return this->pocket_x.size(); }
+
+    /**
+     * Returns the sum of every pocket's kernel at the given position
+     */
+    double get_factor( const coordinate &position ) const
+    { return ( this->*( this->accumulator ) )( position ); }
+
+  protected:
+    /**
+     * Adds up the kernel of every pocket (or every pocket within the cutoff)
+     */
+    template< class kernel > double accumulate( const coordinate &position ) const;
+
+  private:
+    /**
+     * The accumulator specialised for the current kernel type
+     */
+    double ( pocket_field::*accumulator )( const coordinate& ) const;
+
+    /**
+     * The position of each pocket
+     */
+    std::vector< double > pocket_x, pocket_y;
+
+    /**
+     * The factor that distances are divided by before applying the kernel
+     */
+    double scaling;
+
+    /**
+     * The number of scaled distances beyond which pockets are ignored (0 for no cutoff)
+     */
+    double cutoff;
+
+    /**
+     * The size of each grid cell (the cutoff distance before scaling)
+     */
+    double cell_size;
+
+    /**
+     * The indices of the pockets in each grid cell (only used when there is a cutoff)
+     */
+    std::map< std::pair< int, int >, std::vector< unsigned int > > grid;
+
+    /**
+     * The lowest and highest grid cell indices which contain a pocket
+     */
+    std::pair< int, int > cell_min, cell_max;
+  };
+}
+
+/** @} end of doxygen group */
+
+#endif
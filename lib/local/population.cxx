@@ -11,19 +11,25 @@
 #include "archive.h"
 #include "archive_entry.h"
 #include "building.h"
+#include "csv_writer.h"
 #include "household.h"
 #include "individual.h"
 #include "summary.h"
+#include "tile.h"
 #include "town.h"
 #include "trend.h"
 #include "utilities.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <ctime>
 #include <fstream>
 #include <json/reader.h>
 #include <json/value.h>
 #include <json/writer.h>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 
 namespace sampsim
@@ -57,6 +63,8 @@ namespace sampsim
     this->sd_exposure = new trend;
     this->pocket_kernel_type = "exponential";
     this->pocket_scaling = 1.0;
+    this->pocket_cutoff = 0.0;
+    this->trend_lattice_resolution = 0;
     this->town_size_min = 0.0;
     this->town_size_max = 0.0;
     this->town_size_shape = 0.0;
@@ -110,40 +118,7 @@ namespace sampsim
     // create towns
     for( unsigned int i = 0; i < this->number_of_towns; i++ )
     {
-      town *t = new town( this, i );
-      t->set_number_of_tiles_x( this->number_of_tiles_x );
-      t->set_number_of_tiles_y( this->number_of_tiles_y );
-      t->set_mean_household_population( this->mean_household_population );
-
-      // determine whether to add a river to this town
-      bool has_river = 0 < this->river_width && utilities::random() < this->river_probability;
-      t->set_has_river( has_river );
-      t->set_number_of_disease_pockets( this->number_of_disease_pockets );
-
-      int individuals = this->town_size_distribution.generate_value();
-      if( utilities::verbose )
-        utilities::output( "creating town with target size of %d individuals", individuals );
-
-      // determine the base population density for this town
-      double town_x_width = this->tile_width * this->number_of_tiles_x;
-      double town_y_width = this->tile_width * this->number_of_tiles_y;
-
-      double b00 = individuals / town_x_width / town_y_width;
-      double b01 = b00 * this->population_density_slope[0] / town_x_width;
-      double b10 = b00 * this->population_density_slope[1] / town_y_width;
-
-      // now make sure this is the value at the centre of the town
-      b00 -= b01 * town_x_width / 2 + b10 * town_y_width / 2;
-
-      trend* population_density = t->get_population_density();
-      population_density->set_b00( b00 );
-      population_density->set_b01( b01 );
-      population_density->set_b10( b10 );
-      population_density->set_b02( 0.0 );
-      population_density->set_b20( 0.0 );
-      population_density->set_b11( 0.0 );
-
-      t->create();
+      town *t = this->create_town( i );
       this->town_list.push_back( t );
       this->number_of_individuals += t->get_number_of_individuals();
     }
@@ -153,6 +128,47 @@ namespace sampsim
     this->expire_summary();
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  town* population::create_town( const unsigned int index, const bool measure_only )
+  {
+    town *t = new town( this, index );
+    t->set_number_of_tiles_x( this->number_of_tiles_x );
+    t->set_number_of_tiles_y( this->number_of_tiles_y );
+    t->set_mean_household_population( this->mean_household_population );
+
+    // determine whether to add a river to this town
+    bool has_river = 0 < this->river_width && utilities::random() < this->river_probability;
+    t->set_has_river( has_river );
+    t->set_number_of_disease_pockets( this->number_of_disease_pockets );
+
+    int individuals = this->town_size_distribution.generate_value();
+    if( utilities::verbose )
+      utilities::output( "creating town with target size of %d individuals", individuals );
+
+    // determine the base population density for this town
+    double town_x_width = this->tile_width * this->number_of_tiles_x;
+    double town_y_width = this->tile_width * this->number_of_tiles_y;
+
+    double b00 = individuals / town_x_width / town_y_width;
+    double b01 = b00 * this->population_density_slope[0] / town_x_width;
+    double b10 = b00 * this->population_density_slope[1] / town_y_width;
+
+    // now make sure this is the value at the centre of the town
+    b00 -= b01 * town_x_width / 2 + b10 * town_y_width / 2;
+
+    trend* population_density = t->get_population_density();
+    population_density->set_b00( b00 );
+    population_density->set_b01( b01 );
+    population_density->set_b10( b10 );
+    population_density->set_b02( 0.0 );
+    population_density->set_b20( 0.0 );
+    population_density->set_b11( 0.0 );
+
+    if( measure_only ) t->measure();
+    else t->create();
+    return t;
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void population::define()
   {
@@ -169,36 +185,178 @@ namespace sampsim
     }
     double mean_log_individual_count = sum_log_individual_count / this->number_of_towns;
 
-    // now set the regression factor for all trends in each town
+    // now define each town
     auto log_it = town_log_individual_count.cbegin();
-    for( auto town_it = this->town_list.cbegin(); town_it != this->town_list.cend(); ++town_it )
+    for( auto town_it = this->town_list.cbegin(); town_it != this->town_list.cend(); ++town_it, ++log_it )
+      this->define_town( *town_it, safe_subtract( *log_it, mean_log_individual_count ) );
+
+    utilities::output( "finished defining population, %d individuals generated", this->number_of_individuals );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::define_town( town *t, const double factor )
+  {
+    // here we set the regression factor for all trends
+    // Note: the regression factor shouldn't be confused with the coefficient's regression coefficient.
+    // This parameter is set when defining the trend, not here.
+    t->get_mean_income()->copy( this->mean_income );
+    t->get_mean_income()->set_regression_factor( factor );
+    t->get_sd_income()->copy( this->sd_income );
+    t->get_sd_income()->set_regression_factor( factor );
+    t->get_mean_disease()->copy( this->mean_disease );
+    t->get_mean_disease()->set_regression_factor( factor );
+    t->get_sd_disease()->copy( this->sd_disease );
+    t->get_sd_disease()->set_regression_factor( factor );
+    t->get_mean_exposure()->copy( this->mean_exposure );
+    t->get_mean_exposure()->set_regression_factor( factor );
+    t->get_sd_exposure()->copy( this->sd_exposure );
+    t->get_sd_exposure()->set_regression_factor( factor );
+
+    t->set_number_of_disease_pockets( this->number_of_disease_pockets );
+    t->define();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::generate_streaming( const std::string filename )
+  {
+    utilities::output( "generating population one town at a time" );
+
+    Json::StyledWriter writer;
+    Json::Value root, header_root;
+    this->to_json( root );
+    root.removeMember( "town_list" );
+    root["town_entry_list"] = Json::Value( Json::arrayValue );
+    header_root["version"] = utilities::get_version();
+    header_root["town_list"] = Json::Value( Json::arrayValue );
+
+    utilities::output(
+      "writing population to %s.json%s", filename.c_str(), utilities::get_archive_extension().c_str() );
+    utilities::archive_writer archive;
+    archive.open( filename + ".json" );
+    this->generate_by_town( [&]( town *t )
     {
-      town *t = *town_it;
-      double factor = safe_subtract( *log_it, mean_log_individual_count );
-
-      // here we set the regression factor for all trends
-      // Note: the regression factor shouldn't be confused with the coefficient's regression coefficient.
-      // This parameter is set when defining the trend, not here.
-      t->get_mean_income()->copy( this->mean_income );
-      t->get_mean_income()->set_regression_factor( factor );
-      t->get_sd_income()->copy( this->sd_income );
-      t->get_sd_income()->set_regression_factor( factor );
-      t->get_mean_disease()->copy( this->mean_disease );
-      t->get_mean_disease()->set_regression_factor( factor );
-      t->get_sd_disease()->copy( this->sd_disease );
-      t->get_sd_disease()->set_regression_factor( factor );
-      t->get_mean_exposure()->copy( this->mean_exposure );
-      t->get_mean_exposure()->set_regression_factor( factor );
-      t->get_sd_exposure()->copy( this->sd_exposure );
-      t->get_sd_exposure()->set_regression_factor( factor );
-
-      t->set_number_of_disease_pockets( this->number_of_disease_pockets );
-      t->define();
-
-      ++log_it;
+      std::stringstream stream;
+      stream << filename << ".t" << std::setw( log( this->number_of_towns+1 ) ) << std::setfill( '0' )
+             << t->get_index() << ".json";
+      Json::Value town_root;
+      t->to_json( town_root );
+      archive.write_entry( stream.str(), writer.write( town_root ) );
+      root["town_entry_list"].append( stream.str() );
+
+      summary town_summary;
+      town_summary.add( t );
+      Json::Value child;
+      town_summary.to_json( child );
+      header_root["town_list"].append( child );
+    } );
+
+    this->sum->to_json( header_root["summary"] );
+    archive.write_entry( filename + ".json", writer.write( root ) );
+    archive.write_entry( filename + ".header.json", writer.write( header_root ) );
+    archive.close();
+
+    utilities::output( "finished generating population, %d individuals generated", this->number_of_individuals );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::generate_summary()
+  {
+    utilities::output( "generating population summary one town at a time" );
+    this->generate_by_town( []( town *t ) {} );
+    utilities::output( "finished generating population summary, %d individuals counted",
+                       this->number_of_individuals );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::generate_by_town( const std::function< void( town* ) > &callback )
+  {
+    // delete all towns and turn off sample mode (in case it is on)
+    this->current_household_index = 0;
+    this->current_individual_index = 0;
+    this->number_of_individuals = 0;
+    std::for_each( this->town_list.begin(), this->town_list.end(), utilities::safe_delete_type() );
+    this->town_list.clear();
+    this->household_map.clear();
+    this->individual_map.clear();
+    this->set_sample_mode( false );
+
+    // create a distribution to determine town size
+    this->town_size_distribution.set_pareto(
+      this->town_size_min, this->town_size_shape, this->town_size_max );
+
+    // Defining a town depends on the size of every town, so each town is first measured, drawing the same
+    // random numbers as creating it would but without creating any of its tiles.  The random generator's
+    // state is kept so that the town can be created later, when it is defined, using the random numbers
+    // which follow the last town's creation just as they would be by generate().
+    std::vector< std::mt19937 > engine_list;
+    std::vector< double > town_log_individual_count;
+    double sum_log_individual_count = 0;
+    for( unsigned int i = 0; i < this->number_of_towns; i++ )
+    {
+      engine_list.push_back( utilities::random_engine );
+      town *t = this->create_town( i, true );
+      double log_individuals = log10( t->get_number_of_individuals() );
+      town_log_individual_count.push_back( log_individuals );
+      sum_log_individual_count += log_individuals;
+      this->number_of_individuals += t->get_number_of_individuals();
+      utilities::safe_delete( t );
     }
+    double mean_log_individual_count = sum_log_individual_count / this->number_of_towns;
+    std::mt19937 define_engine = utilities::random_engine;
 
-    utilities::output( "finished defining population, %d individuals generated", this->number_of_individuals );
+    // now create, define and summarise each town in turn, deleting it before moving on to the next
+    summary *sum = this->reset_summary();
+    this->stratified.reset();
+    for( unsigned int i = 0; i < this->number_of_towns; i++ )
+    {
+      utilities::random_engine = engine_list[i];
+      town *t = this->create_town( i );
+      this->town_list.push_back( t );
+
+      utilities::random_engine = define_engine;
+      this->define_town( t, safe_subtract( town_log_individual_count[i], mean_log_individual_count ) );
+      define_engine = utilities::random_engine;
+
+      t->rebuild_summary();
+      sum->add( t );
+      if( 0 < this->stratified.get_number_of_dimensions() ) this->stratified.add( t );
+      callback( t );
+
+      this->town_list.clear();
+      utilities::safe_delete( t );
+      this->household_map.clear();
+      this->individual_map.clear();
+    }
+
+    // the population's summary is complete even though none of its towns remain
+    this->expired = false;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::redefine( const population *parameters )
+  {
+    utilities::output( "redefining population using existing geometry" );
+
+    // copy all parameters used by the define stage
+    this->set_sample_mode( false );
+    this->seed = parameters->seed;
+    this->target_prevalence = parameters->target_prevalence;
+    for( unsigned int c = 0; c < population::NUMBER_OF_DISEASE_WEIGHTS; c++ )
+      this->disease_weights[c] = parameters->disease_weights[c];
+    this->number_of_disease_pockets = parameters->number_of_disease_pockets;
+    this->pocket_kernel_type = parameters->pocket_kernel_type;
+    this->pocket_scaling = parameters->pocket_scaling;
+    this->pocket_cutoff = parameters->pocket_cutoff;
+    this->trend_lattice_resolution = parameters->trend_lattice_resolution;
+    this->mean_income->copy( parameters->mean_income );
+    this->sd_income->copy( parameters->sd_income );
+    this->mean_disease->copy( parameters->mean_disease );
+    this->sd_disease->copy( parameters->sd_disease );
+    this->mean_exposure->copy( parameters->mean_exposure );
+    this->sd_exposure->copy( parameters->sd_exposure );
+
+    this->define();
+    this->expire_summary();
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -211,10 +369,53 @@ namespace sampsim
     {
       Json::Value root;
       Json::Reader reader;
-      file_list_type files = utilities::read_gzip( filename );
-      success = reader.parse( files.cbegin()->second, root, false );
+      bool found = false;
+      std::map< std::string, Json::Value > town_map;
+
+      // the population is usually the archive's only entry other than its (optional) summary header,
+      // but populations written by generate_streaming() have one entry per town which come first
+      utilities::for_each_entry(
+        filename,
+        [&]( const std::string &name, std::istream &stream )
+        {
+          std::vector< std::string > parts = utilities::explode( name, "." );
+          if( 2 <= parts.size() && "header" == parts.at( parts.size()-2 ) ) return true;
+          Json::Value value;
+          success = reader.parse( stream, value, false );
+          if( !success ) return false;
+          if( value.isMember( "town_list" ) || value.isMember( "town_entry_list" ) )
+          {
+            found = true;
+            root.swap( value );
+            return root.isMember( "town_entry_list" );
+          }
+          town_map[name].swap( value );
+          return true;
+        } );
+
+      // put the separate town entries back into the population
+      if( success && found && root.isMember( "town_entry_list" ) )
+      {
+        root["town_list"] = Json::Value( Json::arrayValue );
+        for( unsigned int c = 0; c < root["town_entry_list"].size(); c++ )
+        {
+          auto it = town_map.find( root["town_entry_list"][c].asString() );
+          if( town_map.end() == it )
+          {
+            std::stringstream stream;
+            stream << "Town entry \"" << root["town_entry_list"][c].asString() << "\" is missing";
+            throw std::runtime_error( stream.str() );
+          }
+          root["town_list"].append( Json::Value() ).swap( it->second );
+        }
+      }
 
-      if( !success )
+      if( !found && success )
+      {
+        std::cout << "ERROR: file \"" << filename << "\" does not contain a population" << std::endl;
+        success = false;
+      }
+      else if( !success )
       {
         std::cout << "ERROR: failed to parse file \"" << filename << "\"" << std::endl
                   << reader.getFormattedErrorMessages();
@@ -236,23 +437,33 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void population::write( const std::string filename, const bool flat_file ) const
   {
-    utilities::output( "writing population to %s.%s.tar.gz", filename.c_str(), flat_file ? "flat" : "json" );
+    utilities::output(
+      "writing population to %s.%s%s",
+      filename.c_str(),
+      flat_file ? "flat" : "json",
+      utilities::get_archive_extension().c_str() );
 
     if( flat_file )
     {
-      std::stringstream household_stream, individual_stream;
-      this->to_csv( household_stream, individual_stream );
+      csv_writer household_writer, individual_writer;
+      this->to_csv( household_writer, individual_writer );
       file_list_type files;
-      files[filename + ".household.csv"] = household_stream.str();
-      files[filename + ".individual.csv"] = individual_stream.str();
+      files[filename + ".household.csv"] = household_writer.take();
+      files[filename + ".individual.csv"] = individual_writer.take();
       utilities::write_gzip( filename + ".flat", files, true );
     }
     else
     {
-      Json::Value root;
+      Json::Value root, header_root;
       this->to_json( root );
+      this->summary_to_json( header_root );
       Json::StyledWriter writer;
-      utilities::write_gzip( filename + ".json", writer.write( root ) );
+      file_list_type files;
+
+      // the header's name sorts before the population's so it is the archive's first entry
+      files[filename + ".header.json"] = writer.write( header_root );
+      files[filename + ".json"] = writer.write( root );
+      utilities::write_gzip( filename + ".json", files );
     }
 
     utilities::output( "finished writing population" );
@@ -267,6 +478,111 @@ namespace sampsim
     stream.close();
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::write_stratified_summary( const std::string filename )
+  {
+    // populations generated one town at a time have no towns left, their strata were counted as they went
+    if( !this->town_list.empty() )
+    {
+      this->stratified.reset();
+      this->stratified.add( this );
+    }
+
+    std::ofstream stream( filename + ".stratified.csv", std::ofstream::out );
+    this->stratified.write( stream, "population" );
+    stream.close();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  bool population::write_summary_from_header( const std::string filename, const std::string output_filename )
+  {
+    std::string data;
+    Json::Value root;
+    Json::Reader reader;
+    summary sum;
+    if( !utilities::read_first_entry( filename, ".header.json", data ) ||
+        !reader.parse( data, root, false ) ||
+        !sum.from_json( root["summary"] ) ) return false;
+
+    utilities::output( "writing population summary from the header of %s", filename.c_str() );
+    std::ofstream stream( output_filename + ".csv", std::ofstream::out );
+    sum.write( stream );
+    stream.close();
+    return true;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::summary_to_json( Json::Value &json ) const
+  {
+    // building the summaries only fills in their cached values so the population isn't really changed
+    population *self = const_cast< population* >( this );
+    json = Json::Value( Json::objectValue );
+    json["version"] = utilities::get_version();
+    self->get_summary()->to_json( json["summary"] );
+    json["town_list"] = Json::Value( Json::arrayValue );
+    for( auto it = this->town_list.cbegin(); it != this->town_list.cend(); ++it )
+    {
+      Json::Value child;
+      ( *it )->get_summary()->to_json( child );
+      json["town_list"].append( child );
+    }
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  std::string population::get_content_hash() const
+  {
+    // 64-bit FNV-1a hash
+    unsigned long long hash = 14695981039346656037ULL;
+    auto add = [&hash]( const unsigned long long value )
+    {
+      for( unsigned int b = 0; b < 8; b++ )
+      {
+        hash ^= ( value >> ( 8*b ) ) & 0xff;
+        hash *= 1099511628211ULL;
+      }
+    };
+
+    for( auto it = this->seed.cbegin(); it != this->seed.cend(); ++it ) add( *it );
+    add( this->town_list.size() );
+    for( auto town_it = this->town_list.cbegin(); town_it != this->town_list.cend(); ++town_it )
+    {
+      town *t = *town_it;
+      add( t->get_index() );
+      for( auto tile_it = t->get_tile_list_cbegin(); tile_it != t->get_tile_list_cend(); ++tile_it )
+      {
+        tile *ti = tile_it->second;
+        for( auto building_it = ti->get_building_list_cbegin();
+             building_it != ti->get_building_list_cend();
+             ++building_it )
+        {
+          building *b = *building_it;
+          for( auto household_it = b->get_household_list_cbegin();
+               household_it != b->get_household_list_cend();
+               ++household_it )
+          {
+            household *h = *household_it;
+            add( h->get_index() );
+            for( auto individual_it = h->get_individual_list_cbegin();
+                 individual_it != h->get_individual_list_cend();
+                 ++individual_it )
+            {
+              individual *i = *individual_it;
+              add( i->get_index() );
+              add( i->get_age() );
+              add( i->get_sex() );
+              add( i->get_exposure() );
+              for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) add( i->get_state( rr ) );
+            }
+          }
+        }
+      }
+    }
+
+    std::stringstream stream;
+    stream << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash;
+    return stream.str();
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void population::from_json( const Json::Value &json )
   {
@@ -282,6 +598,24 @@ namespace sampsim
       throw std::runtime_error( stream.str() );
     }
 
+    // individuals store one disease status per relative risk so the lists must match (older files
+    // without a list are checked by the number of disease states each individual has)
+    if( json.isMember( "rr" ) )
+    {
+      bool same_rr = json["rr"].size() == utilities::rr.size();
+      for( unsigned int rr = 0; same_rr && rr < utilities::rr.size(); rr++ )
+        same_rr = json["rr"][rr].asDouble() == utilities::rr[rr];
+      if( !same_rr )
+      {
+        std::stringstream stream;
+        stream << "Cannot read population, it was generated with relative risks ";
+        for( unsigned int rr = 0; rr < json["rr"].size(); rr++ )
+          stream << ( 0 == rr ? "" : "," ) << json["rr"][rr].asDouble();
+        stream << " (use the same --rr option to read it)";
+        throw std::runtime_error( stream.str() );
+      }
+    }
+
     this->number_of_individuals = 0;
     this->seed = json["seed"].asString();
     this->use_sample_weights = json["use_sample_weights"].asBool();
@@ -327,6 +661,8 @@ namespace sampsim
     json = Json::Value( Json::objectValue );
     json["version"] = utilities::get_version();
     json["seed"] = this->seed;
+    json["rr"] = Json::Value( Json::arrayValue );
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) json["rr"].append( utilities::rr[rr] );
     json["use_sample_weights"] = this->use_sample_weights;
     json["number_of_towns"] = this->number_of_towns;
     json["town_size_min"] = this->town_size_min;
@@ -366,8 +702,16 @@ namespace sampsim
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
-  void population::to_csv(
-    std::ostream &household_stream, std::ostream &individual_stream ) const
+  void population::to_csv( std::ostream &household_stream, std::ostream &individual_stream ) const
+  {
+    csv_writer household_writer, individual_writer;
+    this->to_csv( household_writer, individual_writer );
+    household_stream << household_writer.str();
+    individual_stream << individual_writer.str();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::to_csv( csv_writer &household_writer, csv_writer &individual_writer ) const
   {
     // put in the parameters
     std::stringstream stream;
@@ -402,21 +746,44 @@ namespace sampsim
            << "# sd_exposure trend: " << this->sd_exposure->to_string() << std::endl
            << "#" << std::endl << std::endl;
 
-    household_stream << stream.str();
-    individual_stream << stream.str();
+    household_writer << stream.str();
+    individual_writer << stream.str();
 
     // put in the csv headers
-    household_stream << "town_index,household_index,x,y,r,a,individuals,income,disease_risk,exposure_risk";
+    household_writer << "town_index,household_index,x,y,r,a,individuals,income,disease_risk,exposure_risk";
+
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) household_writer << ",rr" << utilities::rr[rr];
+    household_writer << '\n';
+    individual_writer << "town_index,household_index,individual_index,age,sex,exposed";
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) individual_writer << ",rr" << utilities::rr[rr];
+    if( this->use_sample_weights ) individual_writer << ",weight";
+    individual_writer << '\n';
+
+    // towns only read from the population so they can be written in parallel, one pair of writers each
+    // (building each town's header first makes sure any random trend constants are drawn in order)
+    unsigned int number_of_towns = this->town_list.size();
+    for( auto it = this->town_list.cbegin(); it != this->town_list.cend(); ++it ) ( *it )->get_csv_header();
+    std::vector< csv_writer > household_writer_list( number_of_towns ), individual_writer_list( number_of_towns );
+    std::atomic< unsigned int > next_index( 0 );
+    auto write_towns = [&]()
+    {
+      for( unsigned int index = next_index++; index < number_of_towns; index = next_index++ )
+        this->town_list[index]->to_csv( household_writer_list[index], individual_writer_list[index] );
+    };
 
-    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) household_stream << ",rr" << utilities::rr[rr];
-    household_stream << std::endl;
-    individual_stream << "town_index,household_index,individual_index,age,sex,exposed";
-    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) individual_stream << ",rr" << utilities::rr[rr];
-    if( this->use_sample_weights ) individual_stream << ",weight";
-    individual_stream << std::endl;
+    unsigned int threads = std::min( std::max( std::thread::hardware_concurrency(), 1U ), number_of_towns );
+    std::vector< std::thread > thread_list;
+    for( unsigned int t = 1; t < threads; t++ ) thread_list.push_back( std::thread( write_towns ) );
+    write_towns();
+    for( auto it = thread_list.begin(); it != thread_list.end(); ++it ) it->join();
 
-    for( auto it = this->town_list.cbegin(); it != this->town_list.cend(); ++it )
-      ( *it )->to_csv( household_stream, individual_stream );
+    for( unsigned int index = 0; index < number_of_towns; index++ )
+    {
+      household_writer << household_writer_list[index];
+      individual_writer << individual_writer_list[index];
+      household_writer_list[index].clear();
+      individual_writer_list[index].clear();
+    }
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -448,6 +815,56 @@ namespace sampsim
     return std::pair< double, double >( proportion, variance );
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  cluster_variance population::get_cluster_variance( unsigned int index ) const
+  {
+    cluster_variance variance;
+    for( auto it = this->get_town_list_cbegin(); it != this->get_town_list_cend(); ++it )
+      variance.add_cluster( (*it)->get_number_of_selected_individuals(),
+                            (*it)->get_number_of_selected_diseased_individuals( index ) );
+    return variance;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  std::vector< cluster_variance > population::get_household_cluster_variance_list() const
+  {
+    const unsigned int rr_size = utilities::rr.size();
+    std::vector< cluster_variance > variance_list( rr_size );
+    for( auto town_it = this->get_town_list_cbegin(); town_it != this->get_town_list_cend(); ++town_it )
+    {
+      for( auto tile_it = (*town_it)->get_tile_list_cbegin();
+           tile_it != (*town_it)->get_tile_list_cend();
+           ++tile_it )
+      {
+        for( auto b_it = tile_it->second->get_building_list_cbegin();
+             b_it != tile_it->second->get_building_list_cend();
+             ++b_it )
+        {
+          for( auto h_it = (*b_it)->get_household_list_cbegin();
+               h_it != (*b_it)->get_household_list_cend();
+               ++h_it )
+          {
+            unsigned int selected = 0;
+            std::array< unsigned int, SAMPSIM_MAXIMUM_RR > diseased;
+            diseased.fill( 0 );
+            for( auto i_it = (*h_it)->get_individual_list_cbegin();
+                 i_it != (*h_it)->get_individual_list_cend();
+                 ++i_it )
+            {
+              if( !(*i_it)->is_selected() ) continue;
+              selected++;
+              for( unsigned int rr = 0; rr < rr_size; rr++ ) if( (*i_it)->is_disease( rr ) ) diseased[rr]++;
+            }
+            if( 0 < selected )
+              for( unsigned int rr = 0; rr < rr_size; rr++ )
+                variance_list[rr].add_cluster( selected, diseased[rr] );
+          }
+        }
+      }
+    }
+    return variance_list;
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void population::set_seed( const std::string seed )
   {
@@ -592,6 +1009,25 @@ namespace sampsim
     this->pocket_scaling = scale;
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::set_pocket_cutoff( const double cutoff )
+  {
+    if( utilities::verbose ) utilities::output( "setting pocket_cutoff to %f", cutoff );
+    if( 0 > cutoff )
+    {
+      utilities::output( "invalid pocket cutoff %f, using no cutoff instead", cutoff );
+      this->pocket_cutoff = 0.0;
+    }
+    else this->pocket_cutoff = cutoff;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::set_trend_lattice_resolution( const unsigned int resolution )
+  {
+    if( utilities::verbose ) utilities::output( "setting trend_lattice_resolution to %d", resolution );
+    this->trend_lattice_resolution = resolution;
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   double population::get_disease_weight_by_index( unsigned int index )
   {
@@ -652,19 +1088,55 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void population::rebuild_summary()
   {
-    this->sum.reset();
-    for( auto it = this->town_list.begin(); it != this->town_list.end(); ++it )
+    // towns share no households so their summaries are rebuilt in parallel, one town per thread at a time
+    std::atomic< unsigned int > next( 0 );
+    auto worker = [&]()
+    {
+      for( unsigned int index = next++; index < this->town_list.size(); index = next++ )
+        this->town_list[index]->rebuild_summary();
+    };
+
+    unsigned int threads = std::min(
+      static_cast< unsigned int >( this->town_list.size() ), std::thread::hardware_concurrency() );
+    if( 1 >= threads ) worker();
+    else
     {
-      (*it)->rebuild_summary();
-      this->sum.add( *it );
+      std::vector< std::thread > thread_list;
+      for( unsigned int t = 0; t < threads; t++ ) thread_list.push_back( std::thread( worker ) );
+      for( auto it = thread_list.begin(); it != thread_list.end(); ++it ) it->join();
     }
+
+    // towns are added in order so the result doesn't depend on the number of threads
+    summary *sum = this->reset_summary();
+    for( auto it = this->town_list.begin(); it != this->town_list.end(); ++it ) sum->add( *it );
     this->expired = false;
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void population::copy( const population* object )
   {
-    // copy population parameters
+    this->copy_parameters( object );
+
+    // delete all towns
+    std::for_each( this->town_list.begin(), this->town_list.end(), utilities::safe_delete_type() );
+    this->town_list.clear();
+
+    unsigned int index = 0;
+    for( auto it = object->town_list.cbegin(); it != object->town_list.cend(); ++it )
+    {
+      if( !this->sample_mode || (*it)->is_selected() )
+      {
+        town *t = new town( this, index++ );
+        t->copy( *it );
+        this->town_list.push_back( t );
+      }
+    }
+    this->number_of_towns = index + 1;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void population::copy_parameters( const population* object )
+  {
     this->sample_mode = object->sample_mode;
     this->seed = object->seed;
     this->use_sample_weights = object->use_sample_weights;
@@ -688,25 +1160,12 @@ namespace sampsim
     this->sd_exposure->copy( object->sd_exposure );
     this->pocket_kernel_type = object->pocket_kernel_type;
     this->pocket_scaling = object->pocket_scaling;
+    this->pocket_cutoff = object->pocket_cutoff;
+    this->trend_lattice_resolution = object->trend_lattice_resolution;
     this->town_size_min =  object->town_size_min;
     this->town_size_max =  object->town_size_max;
     this->town_size_shape =  object->town_size_shape;
-
-    // delete all towns
-    std::for_each( this->town_list.begin(), this->town_list.end(), utilities::safe_delete_type() );
-    this->town_list.clear();
-
-    unsigned int index = 0;
-    for( auto it = object->town_list.cbegin(); it != object->town_list.cend(); ++it )
-    {
-      if( !this->sample_mode || (*it)->is_selected() )
-      {
-        town *t = new town( this, index++ );
-        t->copy( *it );
-        this->town_list.push_back( t );
-      }
-    }
-    this->number_of_towns = index + 1;
+    this->number_of_towns = object->number_of_towns;
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
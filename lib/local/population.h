@@ -11,9 +11,13 @@
 
 #include "model_object.h"
 
+#include "cluster_variance.h"
 #include "distribution.h"
+#include "stratified_summary.h"
 #include "utilities.h"
 
+#include <functional>
+
 namespace Json{ class Value; }
 
 /**
@@ -23,6 +27,7 @@ namespace Json{ class Value; }
 
 namespace sampsim
 {
+  class csv_writer;
   class household;
   class individual;
   class town;
@@ -62,6 +67,11 @@ namespace sampsim
     std::string get_name() const { return "population"; }
     void copy( const base_object* o ) { this->copy( static_cast<const population*>( o ) ); }
     void copy( const population* );
+
+    /**
+     * Copies another population's parameters without copying any of its towns
+     */
+    void copy_parameters( const population* );
     void from_json( const Json::Value& );
     void to_json( Json::Value& ) const;
     void to_csv( std::ostream&, std::ostream& ) const;
@@ -77,6 +87,14 @@ namespace sampsim
     void unselect();
     void select_all();
 
+    /**
+     * Output object to two CSV writers (households and individuals)
+     * 
+     * Towns are written into their own pair of writers in parallel (one thread per core) and then
+     * appended in order, so the result is identical to the std::ostream version of this method.
+     */
+    void to_csv( csv_writer&, csv_writer& ) const;
+
     /**
      * Iterator access to child towns
      * 
@@ -118,6 +136,40 @@ namespace sampsim
       this->define();
     }
 
+    /**
+     * Redefines the population using another population's parameters while keeping its geometry
+     * 
+     * Towns, tiles, buildings, households and their members are left as they are (for instance, as
+     * read from an existing population file) and only the define stage is run again: household
+     * income and risk factors, pocket factors, exposure and disease status.  The parameters used by
+     * the define stage (seed, target prevalence, disease weights, disease pockets, income, disease and
+     * exposure trends, trend lattice) are first copied from the given population; parameters which
+     * only affect creation are ignored.  The random generator is not re-seeded, so the result is
+     * statistically equivalent to, but not the same as, generating the population from scratch.
+     */
+    void redefine( const population *parameters );
+
+    /**
+     * Generates the population one town at a time, writing each town to disk as soon as it is defined
+     * 
+     * Only one town is held in memory at a time, which bounds memory use to that of the largest town
+     * instead of the whole population.  Each town is written to its own entry in the population's
+     * archive followed by the population (listing the town entries in order) and its summary header.
+     * The population is identical to the one generate() would create, but since every town's
+     * geometry is created twice this takes longer.  Once finished the population has no towns but
+     * its summary remains available.
+     */
+    void generate_streaming( const std::string filename );
+
+    /**
+     * Generates the population's summary without keeping any of its towns
+     * 
+     * Each town is created, defined and added to the population's summary before being deleted, so
+     * only one town is held in memory at a time.  The summary is identical to the one generate()
+     * would produce and, unlike generate_streaming(), nothing is written to disk.
+     */
+    void generate_summary();
+
     /**
      * Reads a population from disk
      * 
@@ -143,6 +195,46 @@ namespace sampsim
      */
     void write_summary( const std::string filename );
 
+    /**
+     * Returns the summary stratified by household characteristics
+     * 
+     * Dimensions must be added to the stratified summary before generating a population one town at a
+     * time (see generate_streaming() and generate_summary()) since its towns are discarded as soon as they
+     * are counted.
+     */
+    stratified_summary* get_stratified_summary() { return &( this->stratified ); }
+
+    /**
+     * Writes the stratified summary of the population to disk (see stratified_summary::write())
+     */
+    void write_stratified_summary( const std::string filename );
+
+    /**
+     * Writes the summary embedded in a population file without reading the population
+     * 
+     * Population files start with a small header entry containing the population's and each town's
+     * summary counts, so this is much faster than reading the population and calling write_summary().
+     * Returns false if the file doesn't have a usable header (it was written by an older version or
+     * using different relative risks), in which case the population has to be read in full.
+     */
+    static bool write_summary_from_header( const std::string filename, const std::string output_filename );
+
+    /**
+     * Serializes the summary counts of the population and each of its towns
+     * 
+     * This is the header written at the start of population files.
+     */
+    void summary_to_json( Json::Value& ) const;
+
+    /**
+     * Returns a hash identifying the population's contents
+     * 
+     * The hash covers the population's seed and every town, household and individual (including their
+     * indices, ages, sexes, exposures and disease states).  It is used by samples which reference a
+     * population file to make sure that it is the same population that was sampled.
+     */
+    std::string get_content_hash() const;
+
     /**
      * Returns whether the population is in sample mode or not
      * 
@@ -212,6 +304,11 @@ namespace sampsim
      */
     void set_seed( const std::string );
 
+    /**
+     * Gets the random generator's seed
+     */
+    std::string get_seed() const { return this->seed; }
+
     /**
      * Sets whether to calculate sample weights
      */
@@ -369,6 +466,38 @@ namespace sampsim
      */
     void set_pocket_scaling( const double );
 
+    /**
+     * Gets the number of scaled distances beyond which disease pockets are ignored
+     * 
+     * When zero (the default) every disease pocket affects every building.
+     */
+    double get_pocket_cutoff() const { return this->pocket_cutoff; }
+
+    /**
+     * Sets the number of scaled distances beyond which disease pockets are ignored
+     * 
+     * Kernels become negligible far from a pocket (exp(-10) is below 5e-5), so in towns with many
+     * pockets a cutoff avoids visiting every pocket for every building.  Any non-zero cutoff changes
+     * the generated population slightly.
+     */
+    void set_pocket_cutoff( const double );
+
+    /**
+     * Gets the number of lattice cells per tile width used to approximate the town trends
+     * 
+     * When zero (the default) trends are evaluated exactly at every household's position.
+     */
+    unsigned int get_trend_lattice_resolution() const { return this->trend_lattice_resolution; }
+
+    /**
+     * Sets the number of lattice cells per tile width used to approximate the town trends
+     * 
+     * Evaluating a town's trends at every household is fast, so this is only worthwhile for very
+     * large towns.  Trend values are bilinearly interpolated from the lattice, so setting this
+     * changes the generated population.
+     */
+    void set_trend_lattice_resolution( const unsigned int );
+
     /**
      * Gets the total number of disease weights used for determining disease status
      */
@@ -484,10 +613,43 @@ namespace sampsim
      */
     std::pair< double, double > get_variance( unsigned int index ) const;
 
+    /**
+     * Gets the number of selected and selected diseased individuals of every town as clusters
+     * 
+     * Note that this is only valid when individuals have been selected
+     */
+    cluster_variance get_cluster_variance( unsigned int index ) const;
+
+    /**
+     * Gets the number of selected and selected diseased individuals of every household as clusters
+     * 
+     * One set of clusters is returned for every rr, all gathered in a single pass through the population.
+     * Households without any selected individuals are not included.  Note that this is only valid when
+     * individuals have been selected
+     */
+    std::vector< cluster_variance > get_household_cluster_variance_list() const;
+
   protected:
     void create();
     void define();
 
+    /**
+     * Creates the next town (used by create() and generate_streaming())
+     */
+    town* create_town( const unsigned int index, const bool measure_only = false );
+
+    /**
+     * Creates and defines one town at a time, calling the callback with each before it is deleted
+     * 
+     * Used by generate_streaming() and generate_summary(), see their descriptions.
+     */
+    void generate_by_town( const std::function< void( town* ) > &callback );
+
+    /**
+     * Defines a town given the difference between its log size and the mean log size of all towns
+     */
+    void define_town( town*, const double factor );
+
   private:
     /**
      * The number of weights included in determining disease status
@@ -596,6 +758,16 @@ namespace sampsim
      */
     double pocket_scaling;
 
+    /**
+     * The number of scaled distances beyond which disease pockets are ignored (0 for no cutoff)
+     */
+    double pocket_cutoff;
+
+    /**
+     * The number of lattice cells per tile width used to approximate town trends (0 for none)
+     */
+    unsigned int trend_lattice_resolution;
+
     /**
      * The disease weights used to determine disease status
      * 
@@ -678,6 +850,11 @@ namespace sampsim
      * The master expired variable for the population's summaries
      */
     bool expired;
+
+    /**
+     * The population's summary stratified by household characteristics
+     */
+    stratified_summary stratified;
   };
 }
 
@@ -11,6 +11,7 @@
 #include "archive.h"
 #include "archive_entry.h"
 #include "building.h"
+#include "csv_writer.h"
 #include "household.h"
 #include "individual.h"
 #include "population.h"
@@ -18,10 +19,13 @@
 #include "tile.h"
 #include "town.h"
 
+#include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <json/reader.h>
 #include <json/value.h>
 #include <json/writer.h>
+#include <limits>
 #include <stdexcept>
 
 namespace sampsim
@@ -43,11 +47,22 @@ namespace sample
     this->current_town_size = 0;
     this->one_per_household = false;
     this->resample_towns = false;
+    this->summary_only = false;
+    this->variance_list.resize( utilities::rr.size() );
+    this->coverage = false;
+    this->bootstrap_replicates = 0;
+    this->variance_threads = 1;
+    this->estimate_list.resize( utilities::rr.size() );
+    this->design_effect = false;
+    this->town_design_effect_list.resize( utilities::rr.size() );
+    this->household_design_effect_list.resize( utilities::rr.size() );
     this->age = ANY_AGE;
     this->sex = ANY_SEX;
     this->first_building = NULL;
     this->population = NULL;
     this->owns_population = false;
+    this->population_filename = "";
+    this->population_hash = "";
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -61,6 +76,18 @@ namespace sample
     this->current_size = object->current_size;
     this->current_town_size = object->current_town_size;
     this->one_per_household = object->one_per_household;
+    this->town_selector.set_method( object->town_selector.get_method() );
+    this->summary_only = object->summary_only;
+    this->summary_statistics = object->summary_statistics;
+    this->stratified = object->stratified;
+    this->variance_list = object->variance_list;
+    this->coverage = object->coverage;
+    this->bootstrap_replicates = object->bootstrap_replicates;
+    this->variance_threads = object->variance_threads;
+    this->estimate_list = object->estimate_list;
+    this->design_effect = object->design_effect;
+    this->town_design_effect_list = object->town_design_effect_list;
+    this->household_design_effect_list = object->household_design_effect_list;
     this->age = object->age;
     this->sex = object->sex;
     std::cout << "WARNING: copying samples is unable to preserve the first_building selected by the sampler"
@@ -71,6 +98,8 @@ namespace sample
     if( object->owns_population ) this->population->copy( object->population );
     else this->population = object->population;
     this->owns_population = object->owns_population;
+    this->population_filename = object->population_filename;
+    this->population_hash = object->population_hash;
 
     std::for_each(
       this->sampled_population_list.begin(),
@@ -125,58 +154,26 @@ namespace sample
     if( 1 < this->number_of_sample_parts && 1 < this->sample_part )
       this->set_seed( std::to_string( atoi( this->get_seed().c_str() ) + this->sample_part - 1 ) );
 
-    // get the population's total number of individuals
+    // the town selection stage only needs the size of every town
     this->population->set_sample_mode( false );
-    unsigned int total_individuals = this->population->get_number_of_individuals();
-
-    // create look-up table of towns based on their first and last individual number (sequentially)
-    unsigned int cumulative_individuals = 0;
-    std::vector< std::pair< unsigned int, sampsim::town* > > town_lookup;
-    std::vector< unsigned int > town_count_list;
-    town_lookup.resize( this->population->get_number_of_towns() );
+    std::vector< sampsim::town* > town_list;
+    std::vector< unsigned int > town_size_list;
     for( auto town_it = this->population->get_town_list_cbegin();
          town_it != this->population->get_town_list_cend();
          ++town_it )
     {
-      sampsim::town *town = *town_it;
-      unsigned int count = town->get_number_of_individuals();
-      town_count_list.push_back( count );
-      cumulative_individuals += count;
-      town_lookup.push_back( std::pair< unsigned int, sampsim::town* >( cumulative_individuals, town ) );
+      town_list.push_back( *town_it );
+      town_size_list.push_back( (*town_it)->get_number_of_individuals() );
     }
+    this->town_selector.set_size_list( town_size_list );
 
-    // now sample towns
-    unsigned int individual_chunk = floor( total_individuals / this->number_of_towns );
+    // select the towns of every iteration before sampling within any of them
     std::vector< std::vector< unsigned int > > sampled_town_index_list;
     for( unsigned int iteration = this->first_sample_index; iteration <= this->last_sample_index; iteration++ )
     {
-      std::vector< unsigned int > town_index_list;
       if( this->first_sample_index == iteration || this->resample_towns )
-      {
-        unsigned int select_individual = utilities::random( 1, individual_chunk );
-        for( unsigned int town_index = 0; town_index < this->number_of_towns; town_index++ )
-        {
-          // find the town who has the select-individual
-          for( unsigned int index = 0; index < town_lookup.size(); ++index )
-          {
-            if( select_individual < town_lookup[index].first )
-            {
-              town_index_list.push_back( index );
-              break;
-            }
-          }
-          select_individual += individual_chunk;
-        }
-      }
-      else
-      {
-        // make a copy of the first town index list
-        for( auto it = sampled_town_index_list.cbegin()->cbegin();
-             it != sampled_town_index_list.cbegin()->cend();
-             ++it ) town_index_list.push_back( *it );
-      }
-
-      sampled_town_index_list.push_back( town_index_list );
+        sampled_town_index_list.push_back( this->town_selector.select( this->number_of_towns ) );
+      else sampled_town_index_list.push_back( sampled_town_index_list.front() );
     }
 
     this->population->set_sample_mode( true );
@@ -188,6 +185,12 @@ namespace sample
       utilities::safe_delete_type() );
     this->sampled_population_list.clear();
     this->sampled_population_list.reserve( this->last_sample_index - this->first_sample_index + 1 );
+    this->summary_statistics.reset( this->use_sample_weights );
+    this->stratified.reset();
+    this->variance_list.assign( utilities::rr.size(), std::vector< std::pair< double, double > >() );
+    this->estimate_list.assign( utilities::rr.size(), std::vector< estimate_type >() );
+    this->town_design_effect_list.assign( utilities::rr.size(), design_effect_type() );
+    this->household_design_effect_list.assign( utilities::rr.size(), design_effect_type() );
 
     // run selection from the first to the last sample index
     for( unsigned int iteration = this->first_sample_index; iteration <= this->last_sample_index; iteration++ )
@@ -205,9 +208,8 @@ namespace sample
              it != sampled_town_index_list[s_index].cend();
              ++it )
         {
-          sampsim::town *town = town_lookup[*it].second;
-          this->current_town_individual_fraction = 0 == total_individuals ? 0.0 :
-            town_count_list[town->get_index()] / static_cast< double >( total_individuals );
+          sampsim::town *town = town_list[*it];
+          this->current_town_selection_fraction = this->town_selector.get_selection_fraction( *it );
           if( first ) first = false;
           else this->reset_for_next_sample( false );
 
@@ -302,9 +304,50 @@ namespace sample
           }
         }
 
+        // strata depend on whole households and towns so they are counted before the selection is copied
+        if( 0 < this->stratified.get_number_of_dimensions() ) this->stratified.add( this->population );
+
         sampsim::population* sampled_population = new sampsim::population;
         sampled_population->copy( this->population ); // will only copy selected individuals
-        this->sampled_population_list.push_back( sampled_population );
+        if( this->coverage )
+        {
+          for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+          {
+            // bootstrap replicates use their own engines so that the sample itself is unaffected
+            unsigned int bootstrap_seed;
+            std::seed_seq sequence{ static_cast< unsigned int >( atoi( this->seed.c_str() ) ), iteration, rr };
+            sequence.generate( &bootstrap_seed, &bootstrap_seed + 1 );
+
+            cluster_variance clusters = sampled_population->get_cluster_variance( rr );
+            estimate_type estimate;
+            estimate.proportion = clusters.get_proportion();
+            estimate.ratio = clusters.get_ratio_variance();
+            estimate.jackknife = clusters.get_jackknife_variance();
+            estimate.bootstrap = clusters.get_bootstrap_variance(
+              this->bootstrap_replicates, bootstrap_seed, this->variance_threads );
+            this->estimate_list[rr].push_back( estimate );
+          }
+        }
+        if( this->design_effect )
+        {
+          // households are walked once for all rr since it is much slower than counting towns
+          std::vector< cluster_variance > household_list =
+            sampled_population->get_household_cluster_variance_list();
+          for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+          {
+            this->town_design_effect_list[rr].add( sampled_population->get_cluster_variance( rr ) );
+            this->household_design_effect_list[rr].add( household_list[rr] );
+          }
+        }
+        if( this->summary_only )
+        {
+          // record everything the summary and variance files need so the sampled population can go
+          this->summary_statistics.add( sampled_population->get_summary() );
+          for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+            this->variance_list[rr].push_back( sampled_population->get_variance( rr ) );
+          utilities::safe_delete( sampled_population );
+        }
+        else this->sampled_population_list.push_back( sampled_population );
 
         if( 1 < this->number_of_towns )
         {
@@ -366,89 +409,162 @@ namespace sample
   double sample::get_immediate_sample_weight( const sampsim::individual* individual ) const
   {
     // when choosing one individual per household include ratio of household size to (one) individual
-    return ( this->one_per_household ?
-      static_cast< double >( individual->get_household()->get_summary()->get_count( 0, this->age, this->sex ) ) :
-      1.0 );
+    return this->one_per_household ?
+      static_cast< double >( individual->get_household()->get_number_of_members( this->age, this->sex ) ) :
+      1.0;
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   double sample::get_post_sample_weight_factor() const
   {
-    return 1.0 / this->current_town_individual_fraction;
+    return 1.0 / this->current_town_selection_fraction;
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
-  bool sample::read( const std::string filename )
+  bool sample::read( const std::string filename, const std::string population_filename )
   {
     utilities::output( "reading %s sample from %s", this->get_type().c_str(), filename.c_str() );
 
     bool success = true;
     try
     {
-      Json::Value sampler_root, population_root;
       Json::Reader reader;
-      file_list_type files = utilities::read_gzip( filename );
       bool sampler_loaded = false, population_loaded = false;
 
-      for( auto it = files.cbegin(); it != files.cend() && success; ++it )
+      // entries are read one at a time, the first pass loads the sampler and (embedded) population which
+      // are needed before the sampled populations can be loaded by the second pass
+      utilities::for_each_entry(
+        filename,
+        [&]( const std::string &name, std::istream &stream )
+        {
+          std::vector< std::string > parts = utilities::explode( name, "." );
+          int size = parts.size();
+          if( "header" == parts.at( size-2 ) ) return true;
+          else if( "sampler" == parts.at( size-2 ) )
+          {
+            Json::Value sampler_root;
+            success = reader.parse( stream, sampler_root, false );
+            if( success ) this->from_json( sampler_root );
+            sampler_loaded = true;
+          }
+          else if( "population" == parts.at( size-2 ) )
+          {
+            Json::Value population_root;
+            success = reader.parse( stream, population_root, false );
+            if( success )
+            {
+              this->delete_population();
+              this->population = new sampsim::population;
+              this->population->from_json( population_root );
+              this->owns_population = true;
+            }
+            population_loaded = true;
+          }
+          return success && !( sampler_loaded && population_loaded );
+        } );
+
+      // samples which reference their population file need to load it now
+      if( success && sampler_loaded && !population_loaded )
       {
-        std::vector< std::string > parts = utilities::explode( it->first, "." );
-        int size = parts.size();
-        if( "sampler" == parts.at( size-2 ) )
+        std::vector< std::string > candidate_list;
+        if( !population_filename.empty() ) candidate_list.push_back( population_filename );
+        if( !this->population_filename.empty() )
         {
-          success = reader.parse( it->second, sampler_root, false );
-          if( success ) this->from_json( sampler_root );
-          sampler_loaded = true;
+          candidate_list.push_back( this->population_filename );
+          std::string path = utilities::get_filename_path( filename );
+          std::string name = utilities::get_filename_name( this->population_filename );
+          candidate_list.push_back( path.empty() ? name : path + "/" + name );
         }
-        else if( "population" == parts.at( size-2 ) )
+
+        for( auto it = candidate_list.cbegin(); it != candidate_list.cend(); ++it )
         {
-          success = reader.parse( it->second, population_root, false );
-          if( success )
+          if( utilities::file_exists( *it ) )
           {
-            this->population = new sampsim::population;
-            this->population->from_json( population_root );
-            this->owns_population = true;
+            population_loaded = this->set_population( *it );
+            break;
           }
-          population_loaded = true;
         }
       }
 
       if( !sampler_loaded )
       {
         std::cout << "ERROR: sample file \"" << filename << "\" is missing its .sampler file" << std::endl;
+        success = false;
       }
       else if( !population_loaded )
       {
-        std::cout << "ERROR: sample file \"" << filename << "\" is missing its .population file" << std::endl;
+        if( this->population_filename.empty() )
+          std::cout << "ERROR: sample file \"" << filename << "\" is missing its .population file" << std::endl;
+        else
+          std::cout << "ERROR: unable to find the population file \"" << this->population_filename
+                    << "\" referenced by sample file \"" << filename << "\"" << std::endl;
+        success = false;
       }
       else if( success )
       {
+        // make sure the population is the one which was sampled
+        if( !this->population_hash.empty() && this->population_hash != this->population->get_content_hash() )
+        {
+          std::stringstream stream;
+          stream << "The population does not match the one used to create sample file \"" << filename << "\"";
+          throw std::runtime_error( stream.str() );
+        }
+
         this->population->set_use_sample_weights( this->use_sample_weights );
+        std::for_each(
+          this->sampled_population_list.begin(),
+          this->sampled_population_list.end(),
+          utilities::safe_delete_type() );
+        this->sampled_population_list.clear();
         this->sampled_population_list.resize( this->number_of_samples, NULL );
 
-        for( auto it = files.cbegin(); it != files.cend() && success; ++it )
-        {
-          // now get all sampled populations
-          std::vector< std::string > parts = utilities::explode( it->first, "." );
-          int size = parts.size();
-          if( "sampler" != parts.at( size-2 ) && "population" != parts.at( size-2 ) )
+        // now get all sampled populations
+        utilities::for_each_entry(
+          filename,
+          [&]( const std::string &name, std::istream &stream )
           {
-            unsigned int index = atoi( parts.at( size-2 ).substr(1).c_str() ) - 1;
+            std::vector< std::string > parts = utilities::explode( name, "." );
+            int size = parts.size();
+            if( "header" == parts.at( size-2 ) || "sampler" == parts.at( size-2 ) ||
+                "population" == parts.at( size-2 ) ) return true;
+
+            // files are named <name>.sNN.<extension> when there is more than one sample
+            std::string sample_part = parts.at( size-2 );
+            unsigned int index = 1 < this->number_of_samples && 1 < sample_part.size() && 's' == sample_part[0]
+                               ? atoi( sample_part.substr( 1 ).c_str() ) - 1
+                               : 0;
+            if( this->number_of_samples <= index )
+            {
+              std::cout << "WARNING: ignoring unexpected file \"" << name << "\" in sample file" << std::endl;
+              return true;
+            }
 
-            Json::Value sampled_population_root;
-            success = reader.parse( it->second, sampled_population_root, false );
-            if( success )
+            if( "selection" == parts.back() )
             {
-              sampsim::population* sampled_population = new sampsim::population;
-              sampled_population->from_json( sampled_population_root );
-              sampled_population->select_all();
-              this->sampled_population_list[index] = sampled_population;
+              utilities::safe_delete( this->sampled_population_list[index] );
+              this->sampled_population_list[index] = this->decode_selection( utilities::read_stream( stream ) );
             }
-          }
-        }
+            else
+            {
+              Json::Value sampled_population_root;
+              success = reader.parse( stream, sampled_population_root, false );
+              if( success )
+              {
+                sampsim::population* sampled_population = new sampsim::population;
+                sampled_population->from_json( sampled_population_root );
+                sampled_population->select_all();
+                utilities::safe_delete( this->sampled_population_list[index] );
+                this->sampled_population_list[index] = sampled_population;
+              }
+            }
+            return success;
+          } );
+
+        this->population->unselect();
+        this->population->set_sample_mode( false );
       }
 
-      if( !success )
+      if( !success && !reader.getFormattedErrorMessages().empty() )
       {
         std::cout << "ERROR: failed to parse file \"" << filename << "\"" << std::endl
                   << reader.getFormattedErrorMessages();
@@ -475,21 +591,20 @@ namespace sample
     if( flat_file )
     {
       int sample_width = floor( log10( this->number_of_samples ) ) + 1;
-      std::stringstream stream, household_stream, individual_stream;
+      std::stringstream stream;
+      sampsim::csv_writer household_writer, individual_writer;
       file_list_type files;
 
       for( unsigned int s = this->first_sample_index + 1; s < this->last_sample_index + 2; s++ )
       {
         stream.str( "" );
-        household_stream.str( "" );
-        individual_stream.str( "" );
         stream << filename;
         if( 1 < this->number_of_samples ) stream << ".s" << std::setw( sample_width ) << std::setfill( '0' ) << s;
         utilities::write_sample_number = s;
-        this->to_csv( household_stream, individual_stream );
+        this->to_csv( household_writer, individual_writer );
 
-        files[stream.str() + ".household.csv"] = household_stream.str();
-        files[stream.str() + ".individual.csv"] = individual_stream.str();
+        files[stream.str() + ".household.csv"] = household_writer.take();
+        files[stream.str() + ".individual.csv"] = individual_writer.take();
       }
 
       utilities::write_gzip( filename + ".flat", files, true );
@@ -500,26 +615,34 @@ namespace sample
       std::stringstream stream;
       file_list_type files;
       Json::StyledWriter writer;
-      Json::Value sampler_root, population_root;
+      Json::Value header_root, sampler_root, population_root;
 
-      // write the sampler's data
+      // the header's name sorts before all other entries so it is the archive's first entry
+      this->summary_to_json( header_root );
+      files[filename + ".header.json"] = writer.write( header_root );
+
+      // write the sampler's data (which references the population file, if there is one)
       this->to_json( sampler_root );
       files[filename + ".sampler.json"] = writer.write( sampler_root );
 
-      // write the population's data
-      this->population->to_json( population_root );
-      files[filename + ".population.json"] = writer.write( population_root );
+      // only write the population's data if it didn't come from a file
+      if( this->population_filename.empty() )
+      {
+        bool sample_mode = this->population->get_sample_mode();
+        this->population->set_sample_mode( false );
+        this->population->to_json( population_root );
+        this->population->set_sample_mode( sample_mode );
+        files[filename + ".population.json"] = writer.write( population_root );
+      }
 
-      // write the sampled populations' data
+      // write which individuals were selected by each sample
       unsigned int s = this->first_sample_index + 1;
       for( auto it = this->sampled_population_list.cbegin(); it != this->sampled_population_list.cend(); ++it )
       {
         stream.str( "" );
         stream << filename;
         if( 1 < this->number_of_samples ) stream << ".s" << std::setw( sample_width ) << std::setfill( '0' ) << s;
-        Json::Value sampled_population_root;
-        (*it)->to_json( sampled_population_root );
-        files[stream.str() + ".json"] = writer.write( sampled_population_root );
+        if( *it ) files[stream.str() + ".selection"] = this->encode_selection( *it );
         s++;
       }
 
@@ -529,6 +652,103 @@ namespace sample
     utilities::output( "finished writing %s sample", this->get_type().c_str() );
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  std::string sample::encode_selection( const sampsim::population *sampled_population ) const
+  {
+    // gather the index and weight of every individual in the sampled population
+    std::vector< std::pair< unsigned int, double > > selection_list;
+    for( auto town_it = sampled_population->get_town_list_cbegin();
+         town_it != sampled_population->get_town_list_cend();
+         ++town_it )
+    {
+      for( auto tile_it = (*town_it)->get_tile_list_cbegin(); tile_it != (*town_it)->get_tile_list_cend(); ++tile_it )
+      {
+        for( auto building_it = tile_it->second->get_building_list_cbegin();
+             building_it != tile_it->second->get_building_list_cend();
+             ++building_it )
+        {
+          for( auto household_it = (*building_it)->get_household_list_cbegin();
+               household_it != (*building_it)->get_household_list_cend();
+               ++household_it )
+          {
+            for( auto individual_it = (*household_it)->get_individual_list_cbegin();
+                 individual_it != (*household_it)->get_individual_list_cend();
+                 ++individual_it )
+            {
+              individual *i = *individual_it;
+              if( i->is_selected() )
+                selection_list.push_back( std::pair< unsigned int, double >( i->get_index(), i->get_sample_weight() ) );
+            }
+          }
+        }
+      }
+    }
+    std::sort( selection_list.begin(), selection_list.end() );
+
+    // the number of individuals followed by the difference between each sorted index
+    std::string data;
+    utilities::append_varint( data, selection_list.size() );
+    unsigned int last_index = 0;
+    for( auto it = selection_list.cbegin(); it != selection_list.cend(); ++it )
+    {
+      utilities::append_varint( data, it->first - last_index );
+      last_index = it->first;
+    }
+
+    // weights are usually shared by many individuals so they are stored as (run length, weight) pairs
+    for( auto it = selection_list.cbegin(); it != selection_list.cend(); )
+    {
+      auto run_it = it;
+      while( run_it != selection_list.cend() && run_it->second == it->second ) ++run_it;
+      utilities::append_varint( data, run_it - it );
+      utilities::append_double( data, it->second );
+      it = run_it;
+    }
+
+    return data;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  sampsim::population* sample::decode_selection( const std::string &data )
+  {
+    std::string::size_type pos = 0;
+    unsigned long long count = utilities::read_varint( data, pos );
+    std::vector< unsigned int > index_list;
+    index_list.reserve( count );
+    unsigned int index = 0;
+    for( unsigned long long c = 0; c < count; c++ )
+    {
+      index += utilities::read_varint( data, pos );
+      index_list.push_back( index );
+    }
+
+    // select the individuals in the source population then copy them into a new population
+    this->population->set_sample_mode( true );
+    this->population->unselect();
+    auto index_it = index_list.cbegin();
+    while( index_it != index_list.cend() )
+    {
+      unsigned long long run = utilities::read_varint( data, pos );
+      double weight = utilities::read_double( data, pos );
+      for( ; 0 < run && index_it != index_list.cend(); --run, ++index_it )
+      {
+        individual *i;
+        try { i = this->population->get_individual_by_index( *index_it ); }
+        catch( std::out_of_range &e )
+        {
+          std::stringstream stream;
+          stream << "Sampled individual #" << *index_it << " does not exist in the population";
+          throw std::runtime_error( stream.str() );
+        }
+        i->select( weight );
+      }
+    }
+
+    sampsim::population* sampled_population = new sampsim::population;
+    sampled_population->copy( this->population ); // will only copy selected individuals
+    return sampled_population;
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void sample::write_summary( const std::string filename ) const
   {
@@ -537,11 +757,18 @@ namespace sample
     std::ofstream stream( filename + ".csv", std::ofstream::app );
     stream << std::endl;
 
-    // get summaries of all populations and add them up as we go
-    std::vector< sampsim::summary* > summary_list;
-    for( auto it = this->sampled_population_list.cbegin(); it != this->sampled_population_list.cend(); ++it )
-      if( *it ) summary_list.push_back( (*it)->get_summary() );
-    sampsim::summary::write( summary_list, this->use_sample_weights, stream );
+    if( this->summary_only )
+    {
+      this->summary_statistics.write( stream );
+    }
+    else
+    {
+      // get summaries of all populations and add them up as we go
+      std::vector< sampsim::summary* > summary_list;
+      for( auto it = this->sampled_population_list.cbegin(); it != this->sampled_population_list.cend(); ++it )
+        if( *it ) summary_list.push_back( (*it)->get_summary() );
+      sampsim::summary::write( summary_list, this->use_sample_weights, stream );
+    }
 
     stream.close();
   }
@@ -557,18 +784,231 @@ namespace sample
       name_stream << filename << "." << utilities::rr[rr] << ".variance.csv";
       std::ofstream stream( name_stream.str(), std::ofstream::app );
 
-      // calculate the proportion and variance for all populations
-      for( auto it = this->sampled_population_list.cbegin(); it != this->sampled_population_list.cend(); ++it )
+      if( this->summary_only )
+      {
+        // sampled populations were not kept so use the variances recorded when they were generated
+        for( auto it = this->variance_list[rr].cbegin(); it != this->variance_list[rr].cend(); ++it )
+          stream << it->first << "," << it->second << std::endl;
+      }
+      else
+      {
+        // calculate the proportion and variance for all populations
+        for( auto it = this->sampled_population_list.cbegin(); it != this->sampled_population_list.cend(); ++it )
+        {
+          if( *it )
+          {
+            variance = (*it)->get_variance( rr );
+            stream << variance.first << "," << variance.second << std::endl;
+          }
+        }
+      }
+
+      stream.close();
+    }
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::write_coverage( const std::string filename ) const
+  {
+    // the critical value of a two-sided 95% confidence interval
+    const double z = 1.959963984540054;
+
+    std::ofstream stream( filename + ".coverage.csv", std::ofstream::out );
+    stream << "individual_rr,prevalence,samples,ratio_variance,ratio_coverage,"
+           << "jackknife_variance,jackknife_coverage";
+    if( 0 < this->bootstrap_replicates ) stream << ",bootstrap_variance,bootstrap_coverage";
+    stream << std::endl;
+
+    // the population's prevalence covers all of its individuals, not just those which were selected
+    bool sample_mode = this->population->get_sample_mode();
+    this->population->set_sample_mode( false );
+    summary *sum = this->population->get_summary();
+
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+    {
+      double prevalence = sum->get_count_fraction( rr, this->age, this->sex );
+      const std::vector< estimate_type > &list = this->estimate_list[rr];
+
+      // returns the mean variance and the fraction of confidence intervals which contain the prevalence,
+      // both only over iterations whose estimate is defined (nan if there are none)
+      auto get_coverage = [&]( double estimate_type::*member )
       {
-        if( *it )
+        double count = 0, sum_variance = 0, covered = 0;
+        for( auto it = list.cbegin(); it != list.cend(); ++it )
+        {
+          double variance = (*it).*member;
+          if( std::isnan( variance ) ) continue;
+          count++;
+          sum_variance += variance;
+          if( std::abs( it->proportion - prevalence ) <= z * sqrt( variance ) ) covered++;
+        }
+        std::stringstream result;
+        if( 0 == count )
         {
-          variance = (*it)->get_variance( rr );
-          stream << variance.first << "," << variance.second << std::endl;
+          const double nan = std::numeric_limits< double >::quiet_NaN();
+          result << nan << "," << nan;
         }
+        else result << sum_variance / count << "," << covered / count;
+        return result.str();
+      };
+
+      stream << utilities::rr[rr] << "," << prevalence << "," << list.size()
+             << "," << get_coverage( &estimate_type::ratio )
+             << "," << get_coverage( &estimate_type::jackknife );
+      if( 0 < this->bootstrap_replicates ) stream << "," << get_coverage( &estimate_type::bootstrap );
+      stream << std::endl;
+    }
+
+    this->population->set_sample_mode( sample_mode );
+    stream.close();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::write_design_effect( const std::string filename ) const
+  {
+    std::ofstream stream( filename + ".design_effect.csv", std::ofstream::out );
+    stream << "individual_rr,cluster,samples,design_effect,design_effect_stdev,"
+           << "intracluster_correlation,intracluster_correlation_stdev,"
+           << "effective_sample_size,effective_sample_size_stdev" << std::endl;
+
+    auto write_statistic = [&]( const summary_accumulator::statistic_type &statistic )
+    {
+      // the mean needs at least one estimate and the standard deviation two (otherwise nan is written)
+      const double nan = std::numeric_limits< double >::quiet_NaN();
+      stream << "," << ( 0 < statistic.count ? statistic.mean : nan )
+             << "," << ( 1 < statistic.count ? sqrt( statistic.squared_sum / ( statistic.count - 1 ) ) : nan );
+    };
+
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+    {
+      for( unsigned int c = 0; c < 2; c++ )
+      {
+        const design_effect_type &effect =
+          0 == c ? this->town_design_effect_list[rr] : this->household_design_effect_list[rr];
+        stream << utilities::rr[rr] << "," << ( 0 == c ? "town" : "household" ) << "," << effect.deff.count;
+        write_statistic( effect.deff );
+        write_statistic( effect.icc );
+        write_statistic( effect.ess );
+        stream << std::endl;
       }
+    }
+
+    stream.close();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::design_effect_type::add( const cluster_variance &clusters )
+  {
+    double value = clusters.get_design_effect();
+    if( std::isnan( value ) ) return;
+    this->deff.add( value );
+    this->ess.add( clusters.get_effective_sample_size() );
+    value = clusters.get_intracluster_correlation();
+    if( !std::isnan( value ) ) this->icc.add( value );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::write_stratified_summary( const std::string filename ) const
+  {
+    std::ofstream stream( filename + ".stratified.csv", std::ofstream::out );
+
+    // the population's strata cover all of its individuals, not just those which were selected
+    bool sample_mode = this->population->get_sample_mode();
+    this->population->set_sample_mode( false );
+    stratified_summary population_stratified = this->stratified;
+    population_stratified.reset();
+    population_stratified.add( this->population );
+    this->population->set_sample_mode( sample_mode );
+
+    population_stratified.write( stream, "population" );
+    this->stratified.write( stream, "sample", this->use_sample_weights );
+    stream.close();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  bool sample::write_summary_from_header(
+    const std::string filename, const std::string output_filename, const bool variance_only ) const
+  {
+    std::string data;
+    Json::Value root;
+    Json::Reader reader;
+    if( !utilities::read_first_entry( filename, ".header.json", data ) ||
+        !reader.parse( data, root, false ) ||
+        this->get_type() != root["type"].asString() ) return false;
+
+    // make sure all summaries are usable before writing anything
+    sampsim::summary population_summary;
+    std::vector< sampsim::summary > summary_list( root["sample_list"].size() );
+    if( !population_summary.from_json( root["population"] ) ) return false;
+    for( unsigned int index = 0; index < summary_list.size(); index++ )
+      if( !summary_list[index].from_json( root["sample_list"][index]["summary"] ) ) return false;
 
+    utilities::output(
+      "writing %s sample summary from the header of %s", this->get_type().c_str(), filename.c_str() );
+
+    if( !variance_only )
+    {
+      std::ofstream stream( output_filename + ".csv", std::ofstream::out );
+      population_summary.write( stream );
+      stream << std::endl;
+
+      std::vector< sampsim::summary* > pointer_list;
+      for( auto it = summary_list.begin(); it != summary_list.end(); ++it )
+        pointer_list.push_back( &( *it ) );
+      sampsim::summary::write( pointer_list, root["use_sample_weights"].asBool(), stream );
+      stream.close();
+    }
+
+    std::stringstream name_stream;
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+    {
+      name_stream.str( "" );
+      name_stream << output_filename << "." << utilities::rr[rr] << ".variance.csv";
+      std::ofstream stream( name_stream.str(), std::ofstream::app );
+      for( unsigned int index = 0; index < summary_list.size(); index++ )
+      {
+        const Json::Value &variance = root["sample_list"][index]["variance"][rr];
+        stream << variance[0].asDouble() << "," << variance[1].asDouble() << std::endl;
+      }
       stream.close();
     }
+
+    return true;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::summary_to_json( Json::Value &json ) const
+  {
+    json = Json::Value( Json::objectValue );
+    json["version"] = utilities::get_version();
+    json["type"] = this->get_type();
+    json["use_sample_weights"] = this->use_sample_weights;
+
+    // the population's summary covers all of its individuals, not just those which were selected
+    bool sample_mode = this->population->get_sample_mode();
+    this->population->set_sample_mode( false );
+    this->population->get_summary()->to_json( json["population"] );
+    this->population->set_sample_mode( sample_mode );
+
+    json["sample_list"] = Json::Value( Json::arrayValue );
+    for( auto it = this->sampled_population_list.cbegin(); it != this->sampled_population_list.cend(); ++it )
+    {
+      if( *it )
+      {
+        Json::Value child( Json::objectValue );
+        ( *it )->get_summary()->to_json( child["summary"] );
+        child["variance"] = Json::Value( Json::arrayValue );
+        for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+        {
+          std::pair< double, double > variance = ( *it )->get_variance( rr );
+          Json::Value pair( Json::arrayValue );
+          pair.append( variance.first );
+          pair.append( variance.second );
+          child["variance"].append( pair );
+        }
+        json["sample_list"].append( child );
+      }
+    }
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -580,6 +1020,11 @@ namespace sample
     this->population->set_sample_mode( true );
     this->population->set_use_sample_weights( this->use_sample_weights );
     this->owns_population = true;
+
+    // store the full path so that written samples can find the population from any directory
+    char *full_path = realpath( filename.c_str(), NULL );
+    this->population_filename = NULL == full_path ? filename : std::string( full_path );
+    free( full_path );
     return result;
   }
 
@@ -591,6 +1036,7 @@ namespace sample
     this->population->set_sample_mode( true );
     this->population->set_use_sample_weights( this->use_sample_weights );
     this->owns_population = false;
+    this->population_filename = "";
     return true;
   }
 
@@ -667,6 +1113,52 @@ namespace sample
     this->resample_towns = resample_towns;
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::set_town_selection_method( const town_selection::method_type method )
+  {
+    if( utilities::verbose )
+      utilities::output(
+        "setting town_selection_method to %s", town_selection::get_method_type_name( method ).c_str() );
+    this->town_selector.set_method( method );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::set_summary_only( const bool summary_only )
+  {
+    if( utilities::verbose )
+      utilities::output( "setting summary_only to %s", summary_only ? "true" : "false" );
+    this->summary_only = summary_only;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::set_coverage( const bool coverage )
+  {
+    if( utilities::verbose ) utilities::output( "setting coverage to %s", coverage ? "true" : "false" );
+    this->coverage = coverage;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::set_design_effect( const bool design_effect )
+  {
+    if( utilities::verbose )
+      utilities::output( "setting design_effect to %s", design_effect ? "true" : "false" );
+    this->design_effect = design_effect;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::set_bootstrap_replicates( const unsigned int bootstrap_replicates )
+  {
+    if( utilities::verbose ) utilities::output( "setting bootstrap_replicates to %d", bootstrap_replicates );
+    this->bootstrap_replicates = bootstrap_replicates;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::set_variance_threads( const unsigned int variance_threads )
+  {
+    if( utilities::verbose ) utilities::output( "setting variance_threads to %d", variance_threads );
+    this->variance_threads = variance_threads;
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void sample::set_age( const age_type age )
   {
@@ -700,8 +1192,12 @@ namespace sample
     this->number_of_samples = json["number_of_samples"].asUInt();
     this->number_of_towns = json["number_of_towns"].asUInt();
     this->one_per_household = json["one_per_household"].asBool();
+    this->town_selector.set_method(
+      town_selection::get_method_type( json.get( "town_selection", "systematic" ).asString() ) );
     this->age = sampsim::get_age_type( json["age"].asString() );
     this->sex = sampsim::get_sex_type( json["sex"].asString() );
+    this->population_filename = json.get( "population_file", "" ).asString();
+    this->population_hash = json.get( "population_hash", "" ).asString();
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -714,8 +1210,11 @@ namespace sample
     json["number_of_samples"] = this->number_of_samples;
     json["number_of_towns"] = this->number_of_towns;
     json["one_per_household"] = this->one_per_household;
+    json["town_selection"] = town_selection::get_method_type_name( this->town_selector.get_method() );
     json["age"] = sampsim::get_age_type_name( this->age );
     json["sex"] = sampsim::get_sex_type_name( this->sex );
+    if( !this->population_filename.empty() ) json["population_file"] = this->population_filename;
+    if( this->population ) json["population_hash"] = this->population->get_content_hash();
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -732,6 +1231,8 @@ namespace sample
     stream << "# number_of_samples: " << this->number_of_samples << std::endl;
     stream << "# number_of_towns: " << this->number_of_towns << std::endl;
     stream << "# one_per_household: " << ( this->one_per_household ? "true" : "false" ) << std::endl;
+    stream << "# town_selection: " << town_selection::get_method_type_name( this->town_selector.get_method() )
+           << std::endl;
     stream << "# age: " << sampsim::get_age_type_name( this->age ) << std::endl;
     stream << "# sex: " << sampsim::get_sex_type_name( this->sex ) << std::endl;
     return stream.str();
@@ -740,10 +1241,20 @@ namespace sample
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void sample::to_csv( std::ostream &household_stream, std::ostream &individual_stream ) const
   {
-    household_stream << this->get_csv_header() << std::endl;
-    individual_stream << this->get_csv_header() << std::endl;
+    sampsim::csv_writer household_writer, individual_writer;
+    this->to_csv( household_writer, individual_writer );
+    household_stream << household_writer.str();
+    individual_stream << individual_writer.str();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void sample::to_csv( sampsim::csv_writer &household_writer, sampsim::csv_writer &individual_writer ) const
+  {
+    std::string header = this->get_csv_header();
+    household_writer << header << '\n';
+    individual_writer << header << '\n';
     int index = utilities::write_sample_number - this->first_sample_index - 1;
-    this->sampled_population_list[index]->to_csv( household_stream, individual_stream );
+    this->sampled_population_list[index]->to_csv( household_writer, individual_writer );
   }
 }
 }
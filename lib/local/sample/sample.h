@@ -11,10 +11,15 @@
 
 #include "base_object.h"
 
+#include "stratified_summary.h"
+#include "summary_accumulator.h"
+#include "town_selection.h"
 #include "utilities.h"
 
 #include <list>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Json{ class Value; }
 
@@ -25,6 +30,8 @@ namespace Json{ class Value; }
 
 namespace sampsim
 {
+class cluster_variance;
+class csv_writer;
 class individual;
 class population;
 
@@ -69,6 +76,11 @@ namespace sample
     virtual void to_json( Json::Value& ) const;
     virtual void to_csv( std::ostream&, std::ostream& ) const;
 
+    /**
+     * Output the current sample (see utilities::write_sample_number) to two CSV writers
+     */
+    void to_csv( sampsim::csv_writer&, sampsim::csv_writer& ) const;
+
     /**
      * Generates the sample by calling select_next_building() until the ending condition is met
      */
@@ -109,18 +121,23 @@ namespace sample
     /**
      * Reads a sample from disk
      * 
-     * This method opens and reads a text file containing a serialized population object stored in JSON
-     * format.  It returns true if the sample has been successuflly unserialized or false if an
-     * error occurred.
+     * This method opens and reads a file containing the sampler's parameters and the selection made by
+     * every sample iteration.  If the sample references the population file it was drawn from (instead of
+     * including the population) then that file is loaded as well, either from the population_filename
+     * parameter, the path stored in the sample or the sample's directory (in that order).  Samples
+     * written in the older format, where each iteration is a serialized population, can also be read.
+     * It returns true if the sample has been successuflly unserialized or false if an error occurred.
      */
-    bool read( const std::string filename );
+    bool read( const std::string filename, const std::string population_filename = "" );
 
     /**
      * Writes the sample to disk
      * 
-     * This method opens and writes a serialization of the selected inviduals in the sample's population.
-     * If the flat_file parameter is true then the population will be written as two CSV files (one for
-     * households and the other for individuals), otherwise a single file is written in JSON format.
+     * If the flat_file parameter is true then the selected individuals of every sample iteration will be
+     * written as two CSV files (one for households and the other for individuals).  Otherwise the
+     * sampler's parameters are written in JSON format along with a compact list of the individuals (and
+     * their weights) selected by each iteration.  The population itself is only included when it wasn't
+     * loaded from a file, otherwise the population file is referenced by its path and content hash.
      */
     void write( const std::string filename, const bool flat_file = false ) const;
 
@@ -136,6 +153,54 @@ namespace sample
      */
     void write_variance( const std::string filename ) const;
 
+    /**
+     * Writes the mean and coverage of every variance estimate to disk
+     * 
+     * For every rr the ratio, jackknife and (if requested) bootstrap variance estimates are averaged over
+     * all sample iterations along with the fraction of iterations whose 95% confidence interval contains
+     * the population's prevalence.  Iterations for which an estimate is undefined (such as those selecting
+     * fewer than two towns) are left out of that estimate's mean and coverage.  Estimates are only
+     * recorded while generating, see set_coverage().
+     */
+    void write_coverage( const std::string filename ) const;
+
+    /**
+     * Writes the mean design effect, intra-cluster correlation and effective sample size to disk
+     * 
+     * For every rr the estimates of all sample iterations are averaged, once treating towns as clusters
+     * and once treating households as clusters.  Iterations for which an estimate is undefined (such as
+     * those selecting fewer than two clusters) are left out of its mean and standard deviation.  Estimates
+     * are only recorded while generating, see set_design_effect().
+     */
+    void write_design_effect( const std::string filename ) const;
+
+    /**
+     * Returns the sample's summary stratified by household characteristics
+     * 
+     * If any dimensions are added to it before generating then the counts of every sample iteration are
+     * pooled into it, see write_stratified_summary().
+     */
+    stratified_summary* get_stratified_summary() { return &( this->stratified ); }
+
+    /**
+     * Writes the population's and the (pooled) sample's stratified summaries to disk
+     * 
+     * The population's strata include all of its individuals, not just those which were selected.
+     */
+    void write_stratified_summary( const std::string filename ) const;
+
+    /**
+     * Writes the summary and variance files using the summaries embedded in a sample file
+     * 
+     * Sample files start with a small header entry containing the population's summary along with the
+     * summary and variance of every sample iteration, so this is much faster than reading the sample and
+     * calling write_summary() and write_variance().  If variance_only is true then only the variance files
+     * are written.  Returns false without writing anything if the file doesn't have a usable header for
+     * this type of sample (it was written by an older version or using different relative risks).
+     */
+    bool write_summary_from_header(
+      const std::string filename, const std::string output_filename, const bool variance_only = false ) const;
+
     /**
      * Returns the name of the sampling method
      */
@@ -236,6 +301,71 @@ namespace sample
      */
     bool get_resample_towns() const { return this->resample_towns; }
 
+    /**
+     * Sets how towns are selected (systematic PPS by default), see town_selection
+     */
+    void set_town_selection_method( const town_selection::method_type method );
+
+    /**
+     * Returns how towns are selected
+     */
+    town_selection::method_type get_town_selection_method() const { return this->town_selector.get_method(); }
+
+    /**
+     * Sets whether only the summary and variance of the sample will be written
+     * 
+     * When set, each sampled population is added to the sample's summary statistics and deleted as soon
+     * as it has been generated instead of being kept in memory until it is written.  This means that the
+     * sampled population list will be empty and that only write_summary() and write_variance() are
+     * able to write the sample.
+     */
+    void set_summary_only( const bool summary_only );
+
+    /**
+     * Returns whether only the summary and variance of the sample will be written
+     */
+    bool get_summary_only() const { return this->summary_only; }
+
+    /**
+     * Sets whether the variance estimates of every sample iteration are recorded for write_coverage()
+     */
+    void set_coverage( const bool coverage );
+
+    /**
+     * Returns whether the variance estimates of every sample iteration are recorded
+     */
+    bool get_coverage() const { return this->coverage; }
+
+    /**
+     * Sets whether the design effects of every sample iteration are recorded for write_design_effect()
+     */
+    void set_design_effect( const bool design_effect );
+
+    /**
+     * Returns whether the design effects of every sample iteration are recorded
+     */
+    bool get_design_effect() const { return this->design_effect; }
+
+    /**
+     * Sets the number of bootstrap replicates drawn for every sample iteration (0 for no bootstrap)
+     */
+    void set_bootstrap_replicates( const unsigned int bootstrap_replicates );
+
+    /**
+     * Returns the number of bootstrap replicates drawn for every sample iteration
+     */
+    unsigned int get_bootstrap_replicates() const { return this->bootstrap_replicates; }
+
+    /**
+     * Sets the number of threads used to draw bootstrap replicates
+     */
+    void set_variance_threads( const unsigned int variance_threads );
+
+    /**
+     * Returns the number of threads used to draw bootstrap replicates
+     */
+    unsigned int get_variance_threads() const { return this->variance_threads; }
+
     /**
      * Sets what age to restrict the sample to
      */
@@ -344,6 +474,26 @@ namespace sample
      */
     void recalculate_sample_indeces();
 
+    /**
+     * Encodes the individuals selected in a sampled population (and their weights) as a string
+     * 
+     * Individual indices are sorted and stored as variable-length encoded differences followed by
+     * run-length encoded sample weights.
+     */
+    std::string encode_selection( const sampsim::population* ) const;
+
+    /**
+     * Serializes the summaries of the population and of every sample iteration (and their variances)
+     * 
+     * This is the header written at the start of sample files, see write_summary_from_header().
+     */
+    void summary_to_json( Json::Value& ) const;
+
+    /**
+     * Creates a sampled population by selecting the individuals encoded by encode_selection()
+     */
+    sampsim::population* decode_selection( const std::string& );
+
     /**
      * Defines whether this class is reponsible for deleting the memory used by the population object
      */
@@ -354,6 +504,98 @@ namespace sample
      */
     population_list_type sampled_population_list;
 
+    /**
+     * Whether sampled populations are deleted once their summary and variance have been recorded
+     */
+    bool summary_only;
+
+    /**
+     * The statistics of every sampled population's summary (only used when summary_only is set)
+     */
+    summary_accumulator summary_statistics;
+
+    /**
+     * The stratified counts of all sample iterations (only used if it has dimensions)
+     */
+    stratified_summary stratified;
+
+    /**
+     * The proportion and variance of every sampled population, indexed by rr (only used when
+     * summary_only is set)
+     */
+    std::vector< std::vector< std::pair< double, double > > > variance_list;
+
+    /**
+     * @struct estimate_type
+     * @brief A sampled population's prevalence and its variance estimates
+     */
+    struct estimate_type
+    {
+      double proportion;
+      double ratio;
+      double jackknife;
+      double bootstrap;
+    };
+
+    /**
+     * Whether variance estimates are recorded for write_coverage()
+     */
+    bool coverage;
+
+    /**
+     * The number of bootstrap replicates drawn for every sample iteration
+     */
+    unsigned int bootstrap_replicates;
+
+    /**
+     * The number of threads used to draw bootstrap replicates
+     */
+    unsigned int variance_threads;
+
+    /**
+     * The variance estimates of every sampled population, indexed by rr (only used when coverage is set)
+     */
+    std::vector< std::vector< estimate_type > > estimate_list;
+
+    /**
+     * @struct design_effect_type
+     * @brief The running statistics of the design effect estimates of every sample iteration
+     */
+    struct design_effect_type
+    {
+      /**
+       * Adds one sample iteration's estimates, skipping any which are undefined
+       */
+      void add( const cluster_variance& );
+
+      summary_accumulator::statistic_type deff, icc, ess;
+    };
+
+    /**
+     * Whether design effects are recorded for write_design_effect()
+     */
+    bool design_effect;
+
+    /**
+     * The design effect estimates using towns as clusters, indexed by rr
+     */
+    std::vector< design_effect_type > town_design_effect_list;
+
+    /**
+     * The design effect estimates using households as clusters, indexed by rr
+     */
+    std::vector< design_effect_type > household_design_effect_list;
+
+    /**
+     * The (absolute) name of the file the population was loaded from (empty if it was set from memory)
+     */
+    std::string population_filename;
+
+    /**
+     * The content hash of the population as recorded when the sample was read from disk
+     */
+    std::string population_hash;
+
     /**
      * The random generator's seed
      */
@@ -420,6 +662,11 @@ namespace sample
      */
     bool resample_towns;
 
+    /**
+     * The first stage of the sample, which chooses the towns to sample from
+     */
+    town_selection town_selector;
+
     /**
      * What age to restrict the sample to
      */
@@ -436,9 +683,10 @@ namespace sample
     building *first_building;
 
     /**
-     * The fraction of the currently selected town's population to the total population (used for sample weights)
+     * The probability of a single draw selecting the current town (used for sample weights), which for PPS
+     * selection is the fraction of the total population living in the town
      */
-    double current_town_individual_fraction;
+    double current_town_selection_fraction;
   };
 }
 
@@ -17,8 +17,10 @@
 #include "household.h"
 #include "individual.h"
 #include "population.h"
+#include "summary.h"
 #include "tile.h"
 #include "town.h"
+#include "arc_epi.h"
 #include "random.h"
 
 using namespace std;
@@ -126,4 +128,117 @@ TEST( test_sample_sample )
       }
     }
   }
+
+  stringstream temp_filename;
+  unsigned int random1 = sampsim::utilities::random( 1000000, 9999999 );
+  temp_filename << "/tmp/sampsim" << random1;
+  population->write( temp_filename.str(), false );
+
+  // sample a population which was read from disk so that the sample only references it
+  sampsim::sample::random *file_sample = new sampsim::sample::random;
+  CHECK( file_sample->set_population( temp_filename.str() + ".json.tar.gz" ) );
+  file_sample->set_number_of_samples( 3 );
+  file_sample->set_number_of_towns( 2 );
+  file_sample->set_size( 50 );
+  file_sample->set_use_sample_weights( true );
+  file_sample->generate();
+
+  cout << "Testing writing sample which references its population file..." << endl;
+  try { file_sample->write( temp_filename.str() + ".sample", false ); }
+  catch(...) { CHECK( false ); }
+  sampsim::file_list_type files =
+    sampsim::utilities::read_gzip( temp_filename.str() + ".sample.json.tar.gz" );
+  CHECK_EQUAL( 5, files.size() ); // the header, sampler and three selections (no population)
+
+  cout << "Testing reading sample which references its population file..." << endl;
+  sampsim::sample::random *read_sample = new sampsim::sample::random;
+  CHECK( read_sample->read( temp_filename.str() + ".sample.json.tar.gz" ) );
+  auto read_it = read_sample->get_sampled_population_list_cbegin();
+  for( auto it = file_sample->get_sampled_population_list_cbegin();
+       it != file_sample->get_sampled_population_list_cend();
+       ++it, ++read_it )
+  {
+    CHECK( read_it != read_sample->get_sampled_population_list_cend() );
+    if( read_it == read_sample->get_sampled_population_list_cend() ) break;
+    sampsim::summary *sum = (*it)->get_summary();
+    sampsim::summary *read_sum = (*read_it)->get_summary();
+    for( unsigned int rr = 0; rr < sampsim::utilities::rr.size(); rr++ )
+    {
+      CHECK_EQUAL( sum->get_count( rr ), read_sum->get_count( rr ) );
+      CHECK_EQUAL( sum->get_count( rr, sampsim::ANY_AGE, sampsim::ANY_SEX, sampsim::DISEASED ),
+                   read_sum->get_count( rr, sampsim::ANY_AGE, sampsim::ANY_SEX, sampsim::DISEASED ) );
+      CHECK_CLOSE( sum->get_weighted_count( rr ), read_sum->get_weighted_count( rr ), 1e-6 );
+    }
+  }
+
+  cout << "Testing writing the sample's summary from its header..." << endl;
+  read_sample->write_summary( temp_filename.str() + ".full" );
+  read_sample->write_variance( temp_filename.str() + ".full" );
+  CHECK( read_sample->write_summary_from_header(
+    temp_filename.str() + ".sample.json.tar.gz", temp_filename.str() + ".header" ) );
+  CHECK_EQUAL(
+    sampsim::utilities::exec( "cat " + temp_filename.str() + ".full.csv" ),
+    sampsim::utilities::exec( "cat " + temp_filename.str() + ".header.csv" ) );
+  CHECK_EQUAL(
+    sampsim::utilities::exec( "cat " + temp_filename.str() + ".full.1.variance.csv" ),
+    sampsim::utilities::exec( "cat " + temp_filename.str() + ".header.1.variance.csv" ) );
+  sampsim::sample::arc_epi *wrong_type_sample = new sampsim::sample::arc_epi;
+  CHECK( !wrong_type_sample->write_summary_from_header(
+    temp_filename.str() + ".sample.json.tar.gz", temp_filename.str() + ".wrong" ) );
+  sampsim::utilities::safe_delete( wrong_type_sample );
+
+  cout << "Testing a summary-only sample..." << endl;
+  for( unsigned int i = 0; i < 2; i++ )
+  {
+    std::string name = temp_filename.str() + ( 0 == i ? ".kept" : ".summary_only" );
+    sampsim::sample::random *summary_sample = new sampsim::sample::random;
+    summary_sample->set_population( file_sample->get_population() );
+    summary_sample->set_number_of_samples( 3 );
+    summary_sample->set_number_of_towns( 2 );
+    summary_sample->set_size( 50 );
+    summary_sample->set_use_sample_weights( true );
+    summary_sample->set_summary_only( 1 == i );
+    summary_sample->set_seed( "1234" );
+    file_sample->get_population()->unselect(); // other samples leave their selection behind
+    summary_sample->generate();
+    CHECK_EQUAL( 1 == i, summary_sample->get_sampled_population_list_cbegin() ==
+                         summary_sample->get_sampled_population_list_cend() );
+    summary_sample->write_summary( name );
+    summary_sample->write_variance( name );
+    sampsim::utilities::safe_delete( summary_sample );
+  }
+  CHECK_EQUAL(
+    sampsim::utilities::exec( "cat " + temp_filename.str() + ".kept.csv" ),
+    sampsim::utilities::exec( "cat " + temp_filename.str() + ".summary_only.csv" ) );
+  CHECK_EQUAL(
+    sampsim::utilities::exec( "cat " + temp_filename.str() + ".kept.1.variance.csv" ),
+    sampsim::utilities::exec( "cat " + temp_filename.str() + ".summary_only.1.variance.csv" ) );
+
+  cout << "Testing reading sample against a different population..." << endl;
+  sampsim::population *other_population = new sampsim::population;
+  create_test_population( other_population, 2, 1000, 2000 );
+  stringstream other_filename;
+  other_filename << temp_filename.str() << ".other";
+  other_population->write( other_filename.str(), false );
+  sampsim::sample::random *mismatched_sample = new sampsim::sample::random;
+  CHECK( !mismatched_sample->read(
+    temp_filename.str() + ".sample.json.tar.gz", other_filename.str() + ".json.tar.gz" ) );
+
+  cout << "Testing writing and reading sample which includes its population..." << endl;
+  sample->write( temp_filename.str() + ".memory", false );
+  sampsim::sample::random *memory_sample = new sampsim::sample::random;
+  CHECK( memory_sample->read( temp_filename.str() + ".memory.json.tar.gz" ) );
+  CHECK_EQUAL(
+    ( *sample->get_sampled_population_list_cbegin() )->get_summary()->get_count( 0 ),
+    ( *memory_sample->get_sampled_population_list_cbegin() )->get_summary()->get_count( 0 ) );
+
+  // clean up
+  stringstream command;
+  command << "rm " << temp_filename.str() << "*";
+  sampsim::utilities::exec( command.str() );
+  sampsim::utilities::safe_delete( file_sample );
+  sampsim::utilities::safe_delete( read_sample );
+  sampsim::utilities::safe_delete( mismatched_sample );
+  sampsim::utilities::safe_delete( memory_sample );
+  sampsim::utilities::safe_delete( other_population );
 }
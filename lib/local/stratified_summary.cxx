@@ -0,0 +1,261 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   stratified_summary.cxx
+  Language: C++
+
+=========================================================================*/
+
+#include "stratified_summary.h"
+
+#include "building.h"
+#include "household.h"
+#include "individual.h"
+#include "population.h"
+#include "tile.h"
+#include "town.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace sampsim
+{
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void stratified_summary::clear()
+  {
+    this->dimension_list.clear();
+    this->cell_list.assign( 1, summary() );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void stratified_summary::add_dimension( const dimension_type type, const std::vector< double > &edge_list )
+  {
+    if( UNKNOWN_DIMENSION_TYPE == type )
+      throw std::runtime_error( "Tried to stratify a summary by an unknown dimension" );
+
+    for( auto it = this->dimension_list.cbegin(); it != this->dimension_list.cend(); ++it )
+    {
+      if( type == it->type )
+      {
+        std::stringstream stream;
+        stream << "Tried to stratify a summary by " << get_dimension_type_name( type ) << " more than once";
+        throw std::runtime_error( stream.str() );
+      }
+    }
+
+    for( unsigned int index = 1; index < edge_list.size(); index++ )
+    {
+      if( edge_list[index-1] >= edge_list[index] )
+      {
+        std::stringstream stream;
+        stream << "The " << get_dimension_type_name( type ) << " bin edges must be in ascending order";
+        throw std::runtime_error( stream.str() );
+      }
+    }
+
+    dimension d;
+    d.type = type;
+    d.edge_list = edge_list;
+    this->dimension_list.push_back( d );
+
+    // the last dimension varies fastest
+    unsigned int stride = 1;
+    for( auto it = this->dimension_list.rbegin(); it != this->dimension_list.rend(); ++it )
+    {
+      it->stride = stride;
+      stride *= it->edge_list.size() + 1;
+    }
+    this->cell_list.assign( stride, summary() );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void stratified_summary::reset()
+  {
+    for( auto it = this->cell_list.begin(); it != this->cell_list.end(); ++it ) it->reset();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void stratified_summary::add( town *t )
+  {
+    population *pop = t->get_population();
+    bool sample_mode = pop->get_sample_mode();
+    bool use_sample_weights = pop->get_use_sample_weights();
+
+    // income quantiles are relative to all of the town's households, whether they are selected or not
+    std::vector< double > income_list;
+    for( auto it = this->dimension_list.cbegin(); it != this->dimension_list.cend(); ++it )
+    {
+      if( INCOME_QUANTILE != it->type ) continue;
+      for( auto tile_it = t->get_tile_list_begin(); tile_it != t->get_tile_list_end(); ++tile_it )
+        for( auto b_it = tile_it->second->get_building_list_begin();
+             b_it != tile_it->second->get_building_list_end();
+             ++b_it )
+          for( auto h_it = (*b_it)->get_household_list_begin();
+               h_it != (*b_it)->get_household_list_end();
+               ++h_it ) income_list.push_back( (*h_it)->get_income() );
+      std::sort( income_list.begin(), income_list.end() );
+    }
+
+    for( auto tile_it = t->get_tile_list_begin(); tile_it != t->get_tile_list_end(); ++tile_it )
+    {
+      for( auto b_it = tile_it->second->get_building_list_begin();
+           b_it != tile_it->second->get_building_list_end();
+           ++b_it )
+      {
+        building *b = *b_it;
+        if( sample_mode && !b->is_selected() ) continue;
+
+        double pocket_distance = std::numeric_limits< double >::infinity();
+        for( auto it = this->dimension_list.cbegin(); it != this->dimension_list.cend(); ++it )
+        {
+          if( POCKET_DISTANCE != it->type ) continue;
+          for( auto p_it = t->get_disease_pocket_list_cbegin();
+               p_it != t->get_disease_pocket_list_cend();
+               ++p_it ) pocket_distance = std::min( pocket_distance, b->get_position().distance( *p_it ) );
+        }
+
+        for( auto h_it = b->get_household_list_begin(); h_it != b->get_household_list_end(); ++h_it )
+        {
+          household *h = *h_it;
+          if( sample_mode && !h->is_selected() ) continue;
+
+          unsigned int index = 0;
+          for( unsigned int d = 0; d < this->dimension_list.size(); d++ )
+          {
+            double value = 0;
+            dimension_type type = this->dimension_list[d].type;
+            if( INCOME_QUANTILE == type )
+            {
+              value = static_cast< double >(
+                std::lower_bound( income_list.cbegin(), income_list.cend(), h->get_income() ) -
+                income_list.cbegin() ) / income_list.size();
+            }
+            else if( HOUSEHOLD_SIZE == type ) value = h->get_number_of_individuals();
+            else if( POCKET_DISTANCE == type ) value = pocket_distance;
+            index += this->get_bin( d, value ) * this->dimension_list[d].stride;
+          }
+
+          summary *cell = &( this->cell_list[index] );
+          for( auto i_it = h->get_individual_list_cbegin(); i_it != h->get_individual_list_cend(); ++i_it )
+            (*i_it)->add_to_summary( cell, sample_mode, use_sample_weights );
+        }
+      }
+    }
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void stratified_summary::add( population *pop )
+  {
+    bool sample_mode = pop->get_sample_mode();
+    for( auto it = pop->get_town_list_begin(); it != pop->get_town_list_end(); ++it )
+      if( !sample_mode || (*it)->is_selected() ) this->add( *it );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void stratified_summary::add( const stratified_summary *cube )
+  {
+    bool same = this->dimension_list.size() == cube->dimension_list.size();
+    for( unsigned int d = 0; same && d < this->dimension_list.size(); d++ )
+      same = this->dimension_list[d].type == cube->dimension_list[d].type &&
+             this->dimension_list[d].edge_list == cube->dimension_list[d].edge_list;
+    if( !same ) throw std::runtime_error( "Tried to add stratified summaries with different dimensions" );
+
+    for( unsigned int index = 0; index < this->cell_list.size(); index++ )
+      this->cell_list[index].add( &( cube->cell_list[index] ) );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  summary stratified_summary::get_marginal( const unsigned int dimension, const unsigned int bin ) const
+  {
+    const stratified_summary::dimension &d = this->dimension_list[dimension];
+    unsigned int bins = d.edge_list.size() + 1;
+    summary marginal;
+    for( unsigned int index = 0; index < this->cell_list.size(); index++ )
+      if( bin == index / d.stride % bins ) marginal.add( &( this->cell_list[index] ) );
+    return marginal;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void stratified_summary::write( std::ostream &stream, const std::string type, const bool weighted ) const
+  {
+    // the same groups as summary::write()
+    static const std::pair< age_type, sex_type > group_list[] = {
+      { ANY_AGE, ANY_SEX },
+      { ADULT, ANY_SEX }, { CHILD, ANY_SEX },
+      { ANY_AGE, MALE }, { ANY_AGE, FEMALE },
+      { ADULT, MALE }, { ADULT, FEMALE }, { CHILD, MALE }, { CHILD, FEMALE }
+    };
+
+    stream << "type";
+    for( auto it = this->dimension_list.cbegin(); it != this->dimension_list.cend(); ++it )
+    {
+      std::string name = get_dimension_type_name( it->type );
+      stream << "," << name << "_min," << name << "_max";
+    }
+    stream << ",group,individual_rr,diseased,total,rr,prevalence";
+    if( weighted ) stream << ",wrr,wprevalence";
+    stream << std::endl;
+
+    for( unsigned int index = 0; index < this->cell_list.size(); index++ )
+    {
+      // describe the cell by the lower and upper edge of each dimension's bin
+      std::stringstream prefix;
+      prefix << type;
+      for( auto it = this->dimension_list.cbegin(); it != this->dimension_list.cend(); ++it )
+      {
+        unsigned int bin = index / it->stride % ( it->edge_list.size() + 1 );
+        prefix << ",";
+        if( 0 == bin ) prefix << "-Inf";
+        else prefix << it->edge_list[bin-1];
+        prefix << ",";
+        if( it->edge_list.size() == bin ) prefix << "Inf";
+        else prefix << it->edge_list[bin];
+      }
+
+      const summary &cell = this->cell_list[index];
+      for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+      {
+        for( auto it = std::begin( group_list ); it != std::end( group_list ); ++it )
+        {
+          age_type age = it->first;
+          sex_type sex = it->second;
+          std::string group = ANY_AGE == age ? "" : sampsim::get_age_type_name( age );
+          if( ANY_SEX != sex ) group += ( group.empty() ? "" : " " ) + sampsim::get_sex_type_name( sex );
+          if( group.empty() ) group = "total";
+
+          stream << prefix.str() << "," << group
+                 << "," << utilities::rr[rr]
+                 << "," << cell.get_count( rr, age, sex, DISEASED )
+                 << "," << cell.get_count( rr, age, sex )
+                 << "," << cell.get_relative_risk( rr, age, sex )
+                 << "," << cell.get_count_fraction( rr, age, sex );
+          if( weighted )
+            stream << "," << cell.get_weighted_relative_risk( rr, age, sex )
+                   << "," << cell.get_weighted_count_fraction( rr, age, sex );
+          stream << std::endl;
+        }
+      }
+    }
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  unsigned int stratified_summary::get_cell_index( const std::vector< unsigned int > &bin_list ) const
+  {
+    if( bin_list.size() != this->dimension_list.size() )
+      throw std::runtime_error( "Tried to get a stratum without providing a bin for every dimension" );
+
+    unsigned int index = 0;
+    for( unsigned int d = 0; d < this->dimension_list.size(); d++ )
+      index += bin_list[d] * this->dimension_list[d].stride;
+    return index;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  unsigned int stratified_summary::get_bin( const unsigned int dimension, const double value ) const
+  {
+    const std::vector< double > &edge_list = this->dimension_list[dimension].edge_list;
+    return std::upper_bound( edge_list.cbegin(), edge_list.cend(), value ) - edge_list.cbegin();
+  }
+}
@@ -0,0 +1,190 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   stratified_summary.h
+  Language: C++
+
+=========================================================================*/
+
+#ifndef __sampsim_stratified_summary_h
+#define __sampsim_stratified_summary_h
+
+#include "summary.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @addtogroup sampsim
+ * @{
+ */
+
+namespace sampsim
+{
+  class population;
+  class town;
+
+  /**
+   * @class stratified_summary
+   * @author Patrick Emond <emondpd@mcmaster.ca>
+   * @brief A summary broken down by household characteristics
+   * @details
+   * Households are divided into strata by any number of dimensions, each split into bins by a list of
+   * ascending edges (a value equal to an edge belongs to the bin above it).  The strata form a dense
+   * cube in which every cell is an ordinary summary, so the age, sex, state and exposure breakdown and
+   * all of summary's lookups remain available within each stratum.  With no dimensions the cube has a
+   * single cell holding the same counts as the population's summary.
+   */
+  class stratified_summary
+  {
+  public:
+    /**
+     * @enum dimension_type
+     * The household characteristics which can be used to stratify a summary
+     */
+    enum dimension_type
+    {
+      UNKNOWN_DIMENSION_TYPE = 0,
+      INCOME_QUANTILE, // the fraction of the town's households with a lower income
+      HOUSEHOLD_SIZE, // the number of individuals in the household
+      POCKET_DISTANCE // the distance from the household's building to the town's nearest disease pocket
+    };
+
+    /**
+     * Converts the name of a dimension type to its enum value
+     */
+    inline static dimension_type get_dimension_type( const std::string name )
+    {
+      if( "income_quantile" == name ) return INCOME_QUANTILE;
+      else if( "household_size" == name ) return HOUSEHOLD_SIZE;
+      else if( "pocket_distance" == name ) return POCKET_DISTANCE;
+      return UNKNOWN_DIMENSION_TYPE;
+    }
+
+    /**
+     * Converts the enum value of a dimension type to its name
+     */
+    inline static std::string get_dimension_type_name( const dimension_type type )
+    {
+      if( INCOME_QUANTILE == type ) return "income_quantile";
+      else if( HOUSEHOLD_SIZE == type ) return "household_size";
+      else if( POCKET_DISTANCE == type ) return "pocket_distance";
+      return "unknown";
+    }
+
+    /**
+     * Constructor
+     */
+    stratified_summary() { this->clear(); }
+
+    /**
+     * Removes all dimensions (leaving a single empty cell)
+     */
+    void clear();
+
+    /**
+     * Adds a dimension split by the given bin edges
+     *
+     * Throws an exception if the dimension has already been added or if the edges are not in ascending
+     * order.  All counts are reset since the cube's shape changes.
+     */
+    void add_dimension( const dimension_type type, const std::vector< double > &edge_list );
+
+    /**
+     * Returns the number of dimensions
+     */
+    unsigned int get_number_of_dimensions() const { return this->dimension_list.size(); }
+
+    /**
+     * Returns the number of bins of a dimension
+     */
+    unsigned int get_number_of_bins( const unsigned int dimension ) const
+    { return this->dimension_list[dimension].edge_list.size() + 1; }
+
+    /**
+     * Returns the number of cells (strata) in the cube
+     */
+    unsigned int get_number_of_cells() const { return this->cell_list.size(); }
+
+    /**
+     * Returns all counts to 0
+     */
+    void reset();
+
+    /**
+     * Adds a town's individuals to the cube
+     *
+     * When the town's population is in sample mode only selected individuals are counted, but the
+     * strata are still determined using all of the town's households.
+     */
+    void add( town* );
+
+    /**
+     * Adds every town of a population to the cube (only selected towns when in sample mode)
+     */
+    void add( population* );
+
+    /**
+     * Adds another cube's counts to this one
+     *
+     * Throws an exception if the two cubes do not have the same dimensions.
+     */
+    void add( const stratified_summary* );
+
+    /**
+     * Returns the summary of the stratum with the given bin of each dimension
+     */
+    const summary* get_cell( const std::vector< unsigned int > &bin_list ) const
+    { return &( this->cell_list[this->get_cell_index( bin_list )] ); }
+
+    /**
+     * Returns the summary of all strata in one bin of one dimension (summed over all other dimensions)
+     */
+    summary get_marginal( const unsigned int dimension, const unsigned int bin ) const;
+
+    /**
+     * Writes every stratum's summary to a text file, one line per stratum, rr and group
+     *
+     * Each dimension is written as the lower and upper edge of its bin (-Inf and Inf for the first
+     * and last bins).  Weighted relative risk and prevalence columns are included if requested.
+     */
+    void write( std::ostream&, const std::string type, const bool weighted = false ) const;
+
+  private:
+    /**
+     * @struct dimension
+     * @brief A dimension's type, bin edges and the distance between its bins in the cell list
+     */
+    struct dimension
+    {
+      dimension_type type;
+      std::vector< double > edge_list;
+      unsigned int stride;
+    };
+
+    /**
+     * Returns the index of a bin (defined by a list of each dimension's bin) in the cell list
+     */
+    unsigned int get_cell_index( const std::vector< unsigned int > &bin_list ) const;
+
+    /**
+     * Returns which bin of a dimension a value falls into
+     */
+    unsigned int get_bin( const unsigned int dimension, const double value ) const;
+
+    /**
+     * The cube's dimensions, the last of which varies fastest in the cell list
+     */
+    std::vector< dimension > dimension_list;
+
+    /**
+     * One summary for every combination of bins
+     */
+    std::vector< summary > cell_list;
+  };
+}
+
+/** @} end of doxygen group */
+
+#endif
@@ -9,16 +9,16 @@
 #include "summary.h"
 
 #include "model_object.h"
+#include "summary_accumulator.h"
 
 #include <fstream>
+#include <json/value.h>
 
 namespace sampsim
 {
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void summary::reset()
   {
-    this->count.resize( utilities::rr.size() );
-    this->weighted_count.resize( utilities::rr.size() );
     for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
     {
       this->count[rr] = std::array< unsigned, 16 >{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
@@ -26,6 +26,40 @@ namespace sampsim
     }
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  const std::array< summary::marginal_type, summary::NUMBER_OF_MARGINALS >& summary::get_marginal_list()
+  {
+    static const std::array< marginal_type, NUMBER_OF_MARGINALS > marginal_list = []()
+    {
+      std::array< marginal_type, NUMBER_OF_MARGINALS > list;
+      for( auto it = list.begin(); it != list.end(); ++it ) it->size = 0;
+
+      // counts are visited in order so that each marginal's list of counts is in ascending order
+      for( unsigned int i = 0; i < 16; i++ )
+      {
+        // the age, sex, state and exposure of the count at index i (see get_count_index())
+        const age_type age_list[] = { ANY_AGE, 8 & i ? CHILD : ADULT };
+        const sex_type sex_list[] = { ANY_SEX, 4 & i ? FEMALE : MALE };
+        const state_type state_list[] = { ANY_STATE, 2 & i ? DISEASED : HEALTHY };
+        const exposure_type exposure_list[] = { ANY_EXPOSURE, 1 & i ? EXPOSED : NOT_EXPOSED };
+
+        // the count is included in every marginal where each type is either "any" or matches it
+        for( unsigned int m = 0; m < 16; m++ )
+        {
+          marginal_type &marginal = list[summary::get_marginal_index(
+            age_list[8 & m ? 1 : 0],
+            sex_list[4 & m ? 1 : 0],
+            state_list[2 & m ? 1 : 0],
+            exposure_list[1 & m ? 1 : 0] )];
+          marginal.index[marginal.size++] = i;
+        }
+      }
+      return list;
+    }();
+
+    return marginal_list;
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   unsigned int summary::get_count(
     const unsigned int rr,
@@ -34,89 +68,13 @@ namespace sampsim
     const state_type state,
     const exposure_type exposure ) const
   {
-    unsigned int total = 0;
-
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->count[rr][adult_male_healthy_not_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->count[rr][adult_male_healthy_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->count[rr][adult_male_diseased_not_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->count[rr][adult_male_diseased_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->count[rr][adult_female_healthy_not_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->count[rr][adult_female_healthy_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->count[rr][adult_female_diseased_not_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->count[rr][adult_female_diseased_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->count[rr][child_male_healthy_not_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->count[rr][child_male_healthy_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->count[rr][child_male_diseased_not_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->count[rr][child_male_diseased_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->count[rr][child_female_healthy_not_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->count[rr][child_female_healthy_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->count[rr][child_female_diseased_not_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->count[rr][child_female_diseased_exposed];
+    int index = summary::get_marginal_index( age, sex, state, exposure );
+    if( 0 > index ) return 0;
 
+    const marginal_type &marginal = summary::get_marginal_list()[index];
+    const unsigned *count = this->count[rr].data();
+    unsigned int total = 0;
+    for( unsigned int i = 0; i < marginal.size; i++ ) total += count[marginal.index[i]];
     return total;
   }
   
@@ -128,89 +86,13 @@ namespace sampsim
     const state_type state,
     const exposure_type exposure ) const
   {
-    double total = 0;
-
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->weighted_count[rr][adult_male_healthy_not_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->weighted_count[rr][adult_male_healthy_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->weighted_count[rr][adult_male_diseased_not_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->weighted_count[rr][adult_male_diseased_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->weighted_count[rr][adult_female_healthy_not_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->weighted_count[rr][adult_female_healthy_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->weighted_count[rr][adult_female_diseased_not_exposed];
-    if( ( ANY_AGE == age || ADULT == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->weighted_count[rr][adult_female_diseased_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->weighted_count[rr][child_male_healthy_not_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->weighted_count[rr][child_male_healthy_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->weighted_count[rr][child_male_diseased_not_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || MALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->weighted_count[rr][child_male_diseased_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->weighted_count[rr][child_female_healthy_not_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || HEALTHY == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->weighted_count[rr][child_female_healthy_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || NOT_EXPOSED == exposure ) )
-      total += this->weighted_count[rr][child_female_diseased_not_exposed];
-    if( ( ANY_AGE == age || CHILD == age ) &&
-        ( ANY_SEX == sex || FEMALE == sex ) &&
-        ( ANY_STATE == state || DISEASED == state ) &&
-        ( ANY_EXPOSURE == exposure || EXPOSED == exposure ) )
-      total += this->weighted_count[rr][child_female_diseased_exposed];
+    int index = summary::get_marginal_index( age, sex, state, exposure );
+    if( 0 > index ) return 0;
 
+    const marginal_type &marginal = summary::get_marginal_list()[index];
+    const double *weighted_count = this->weighted_count[rr].data();
+    double total = 0;
+    for( unsigned int i = 0; i < marginal.size; i++ ) total += weighted_count[marginal.index[i]];
     return total;
   }
   
@@ -313,7 +195,7 @@ namespace sampsim
   }
   
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
-  void summary::add( summary *sum )
+  void summary::add( const summary *sum )
   {
     for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
     {
@@ -324,7 +206,48 @@ namespace sampsim
       }
     }
   }
-  void summary::add( model_object *model ) { this->add( &(model->sum) ); }
+  void summary::add( model_object *model ) { this->add( model->sum ); }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void summary::to_json( Json::Value &json ) const
+  {
+    json = Json::Value( Json::objectValue );
+    json["rr"] = Json::Value( Json::arrayValue );
+    json["count"] = Json::Value( Json::arrayValue );
+    json["weighted_count"] = Json::Value( Json::arrayValue );
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+    {
+      json["rr"].append( utilities::rr[rr] );
+      Json::Value count( Json::arrayValue ), weighted_count( Json::arrayValue );
+      for( unsigned int i = 0; i < 16; i++ )
+      {
+        count.append( this->count[rr][i] );
+        weighted_count.append( this->weighted_count[rr][i] );
+      }
+      json["count"].append( count );
+      json["weighted_count"].append( weighted_count );
+    }
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  bool summary::from_json( const Json::Value &json )
+  {
+    // the summary can only be used if it was built using the same relative risk values
+    if( !json.isObject() || json["rr"].size() != utilities::rr.size() ) return false;
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+      if( json["rr"][rr].asDouble() != utilities::rr[rr] ) return false;
+
+    this->reset();
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+    {
+      for( unsigned int i = 0; i < 16; i++ )
+      {
+        this->count[rr][i] = json["count"][rr][i].asUInt();
+        this->weighted_count[rr][i] = json["weighted_count"][rr][i].asDouble();
+      }
+    }
+    return true;
+  }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void summary::write( std::ostream &stream ) const
@@ -396,253 +319,8 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void summary::write( std::vector< summary* > summary_list, bool weighted, std::ostream &stream )
   {
-    stream << "type,group,individual_rr,diseased,total,rr,rr_stdev,rr_pooled,prevalence,stdev";
-    if( weighted ) stream << ",wrr,wrr_stdev,wrr_pooled,wprevalence,wstdev";
-    stream << std::endl;
-
-    sampsim::summary total_summary;
-    double mean_array[utilities::rr.size()][9],
-           stdev_array[utilities::rr.size()][9],
-           squared_sum_array[utilities::rr.size()][9],
-           wmean_array[utilities::rr.size()][9],
-           wstdev_array[utilities::rr.size()][9],
-           wsquared_sum_array[utilities::rr.size()][9],
-           rr_mean_array[utilities::rr.size()][9],
-           rr_stdev_array[utilities::rr.size()][9],
-           rr_squared_sum_array[utilities::rr.size()][9],
-           rr_pooled_array[utilities::rr.size()][9],
-           rr_pooled_numerator_sum_array[utilities::rr.size()][9],
-           rr_pooled_denominator_sum_array[utilities::rr.size()][9],
-           rr_wmean_array[utilities::rr.size()][9],
-           rr_wstdev_array[utilities::rr.size()][9],
-           rr_wsquared_sum_array[utilities::rr.size()][9],
-           rr_wpooled_array[utilities::rr.size()][9],
-           rr_wpooled_numerator_sum_array[utilities::rr.size()][9],
-           rr_wpooled_denominator_sum_array[utilities::rr.size()][9];
-
-    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
-    {
-      for( unsigned int index = 0; index < 9; index++ )
-      {
-        mean_array[rr][index] = 0;
-        stdev_array[rr][index] = 0;
-        squared_sum_array[rr][index] = 0;
-        wmean_array[rr][index] = 0;
-        wstdev_array[rr][index] = 0;
-        wsquared_sum_array[rr][index] = 0;
-        rr_mean_array[rr][index] = 0;
-        rr_stdev_array[rr][index] = 0;
-        rr_squared_sum_array[rr][index] = 0;
-        rr_pooled_array[rr][index] = 0;
-        rr_pooled_numerator_sum_array[rr][index] = 0;
-        rr_pooled_denominator_sum_array[rr][index] = 0;
-        rr_wmean_array[rr][index] = 0;
-        rr_wstdev_array[rr][index] = 0;
-        rr_wsquared_sum_array[rr][index] = 0;
-        rr_wpooled_array[rr][index] = 0;
-        rr_wpooled_numerator_sum_array[rr][index] = 0;
-        rr_wpooled_denominator_sum_array[rr][index] = 0;
-      }
-    }
-
-    // add up all summaries in the list and store in total_summary
-    for( auto summary_it = summary_list.begin(); summary_it != summary_list.end(); ++summary_it )
-      total_summary.add( *summary_it );
-
-    // determine mean and standard deviation of values and relative risks for all prevalences
-    double diff, val;
-    unsigned int count, wcount;
-    age_type a;
-    sex_type s;
-    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
-    {
-      for( unsigned int index = 0; index < 9; index++ )
-      {
-        if( 0 <= index && index < 3 ) a = ANY_AGE;
-        else if( 3 <= index && index < 6 ) a = ADULT;
-        else if( 6 <= index && index < 9 ) a = CHILD;
-
-        if( 0 == index % 3 ) s = ANY_SEX;
-        else if( 1 == index % 3 ) s = MALE;
-        else if( 2 == index % 3 ) s = FEMALE;
-
-        // determine the mean prevalence
-        mean_array[rr][index] = total_summary.get_count_fraction( rr, a, s );
-        if( weighted ) wmean_array[rr][index] = total_summary.get_weighted_count_fraction( rr, a, s );
-
-        // determin the mean relative risk
-        count = 0;
-        wcount = 0;
-        for( auto summary_it = summary_list.cbegin(); summary_it != summary_list.cend(); ++summary_it )
-        {
-          summary *sum = *summary_it;
-
-          val = sum->get_relative_risk( rr, a, s );
-          if( !std::isinf( val ) )
-          {
-            count++;
-            rr_mean_array[rr][index] += val;
-          }
-
-          if( weighted )
-          {
-            val = sum->get_weighted_relative_risk( rr, a, s );
-            if( !std::isinf( val ) )
-            {
-              wcount++;
-              rr_wmean_array[rr][index] += val;
-            }
-          }
-        }
-        rr_mean_array[rr][index] /= count;
-        if( weighted ) rr_wmean_array[rr][index] /= wcount;
-
-        // determine the stdev prevalence and relative risk
-        count = 0;
-        wcount = 0;
-        for( auto summary_it = summary_list.cbegin(); summary_it != summary_list.cend(); ++summary_it )
-        {
-          summary *sum = *summary_it;
-
-          diff = sum->get_count_fraction( rr, a, s ) - mean_array[rr][index];
-          squared_sum_array[rr][index] += diff*diff;
-
-          val = sum->get_relative_risk( rr, a, s );
-          if( !std::isinf( val ) ) // don't include infinite rrs
-          {
-            count++;
-            diff = val - rr_mean_array[rr][index];
-            rr_squared_sum_array[rr][index] += diff*diff;
-          }
-
-          rr_pooled_numerator_sum_array[rr][index] += sum->get_pooled_risk_numerator( rr, a, s );
-          rr_pooled_denominator_sum_array[rr][index] += sum->get_pooled_risk_denominator( rr, a, s );
-
-          if( weighted )
-          {
-            diff = sum->get_weighted_count_fraction( rr, a, s ) - wmean_array[rr][index];
-            wsquared_sum_array[rr][index] += diff*diff;
-
-            val = sum->get_weighted_relative_risk( rr, a, s );
-            if( !std::isinf( val ) ) // don't include infinite rrs
-            {
-              wcount++;
-              diff = val - rr_wmean_array[rr][index];
-              rr_wsquared_sum_array[rr][index] += diff*diff;
-            }
-            
-            rr_wpooled_numerator_sum_array[rr][index] += sum->get_weighted_pooled_risk_numerator( rr, a, s );
-            rr_wpooled_denominator_sum_array[rr][index] += sum->get_weighted_pooled_risk_denominator( rr, a, s );
-          }
-        }
-
-        stdev_array[rr][index] = sqrt(
-          squared_sum_array[rr][index] / static_cast<double>( summary_list.size() - 1 )
-        );
-        rr_stdev_array[rr][index] = sqrt( rr_squared_sum_array[rr][index] / count );
-        rr_pooled_array[rr][index] =
-          rr_pooled_numerator_sum_array[rr][index] / rr_pooled_denominator_sum_array[rr][index];
-
-        if( weighted )
-        {
-          wstdev_array[rr][index] = sqrt(
-            wsquared_sum_array[rr][index] / static_cast<double>( summary_list.size() - 1 )
-          );
-          rr_wstdev_array[rr][index] = sqrt( rr_wsquared_sum_array[rr][index] / wcount );
-          rr_wpooled_array[rr][index] =
-            rr_wpooled_numerator_sum_array[rr][index] / rr_wpooled_denominator_sum_array[rr][index];
-        }
-      }
-
-      stream << "sample,total," << utilities::rr[rr]
-             << "," << total_summary.get_count( rr, ANY_AGE, ANY_SEX, DISEASED )
-             << "," << total_summary.get_count( rr, ANY_AGE, ANY_SEX )
-             << "," << rr_mean_array[rr][0] << "," << rr_stdev_array[rr][0] << "," << rr_pooled_array[rr][0]
-             << "," << mean_array[rr][0] << "," << stdev_array[rr][0];
-      if( weighted )
-        stream << "," << rr_wmean_array[rr][0] << "," << rr_wstdev_array[rr][0] << "," << rr_wpooled_array[rr][0]
-               << "," << wmean_array[rr][0] << "," << wstdev_array[rr][0];
-      stream << std::endl;
-
-      stream << "sample,adult," << utilities::rr[rr]
-             << "," << total_summary.get_count( rr, ADULT, ANY_SEX, DISEASED )
-             << "," << total_summary.get_count( rr, ADULT, ANY_SEX )
-             << "," << rr_mean_array[rr][3] << "," << rr_stdev_array[rr][3] << "," << rr_pooled_array[rr][3]
-             << "," << mean_array[rr][3] << "," << stdev_array[rr][3];
-      if( weighted )
-        stream << "," << rr_wmean_array[rr][3] << "," << rr_wstdev_array[rr][3] << "," << rr_wpooled_array[rr][3]
-               << "," << wmean_array[rr][3] << "," << wstdev_array[rr][3];
-      stream << std::endl;
-
-      stream << "sample,child," << utilities::rr[rr]
-             << "," << total_summary.get_count( rr, CHILD, ANY_SEX, DISEASED )
-             << "," << total_summary.get_count( rr, CHILD, ANY_SEX )
-             << "," << rr_mean_array[rr][6] << "," << rr_stdev_array[rr][6] << "," << rr_pooled_array[rr][6]
-             << "," << mean_array[rr][6] << "," << stdev_array[rr][6];
-      if( weighted )
-        stream << "," << rr_wmean_array[rr][6] << "," << rr_wstdev_array[rr][6] << "," << rr_wpooled_array[rr][6]
-               << "," << wmean_array[rr][6] << "," << wstdev_array[rr][6];
-      stream << std::endl;
-
-      stream << "sample,male," << utilities::rr[rr]
-             << "," << total_summary.get_count( rr, ANY_AGE, MALE, DISEASED )
-             << "," << total_summary.get_count( rr, ANY_AGE, MALE )
-             << "," << rr_mean_array[rr][1] << "," << rr_stdev_array[rr][1] << "," << rr_pooled_array[rr][1]
-             << "," << mean_array[rr][1] << "," << stdev_array[rr][1];
-      if( weighted )
-        stream << "," << rr_wmean_array[rr][1] << "," << rr_wstdev_array[rr][1] << "," << rr_wpooled_array[rr][1]
-               << "," << wmean_array[rr][1] << "," << wstdev_array[rr][1];
-      stream << std::endl;
-
-      stream << "sample,female," << utilities::rr[rr]
-             << "," << total_summary.get_count( rr, ANY_AGE, FEMALE, DISEASED )
-             << "," << total_summary.get_count( rr, ANY_AGE, FEMALE )
-             << "," << rr_mean_array[rr][2] << "," << rr_stdev_array[rr][2] << "," << rr_pooled_array[rr][2]
-             << "," << mean_array[rr][2] << "," << stdev_array[rr][2];
-      if( weighted )
-        stream << "," << rr_wmean_array[rr][2] << "," << rr_wstdev_array[rr][2] << "," << rr_wpooled_array[rr][2]
-               << "," << wmean_array[rr][2] << "," << wstdev_array[rr][2];
-      stream << std::endl;
-
-      stream << "sample,male adult," << utilities::rr[rr]
-             << "," << total_summary.get_count( rr, ADULT, MALE, DISEASED )
-             << "," << total_summary.get_count( rr, ADULT, MALE )
-             << "," << rr_mean_array[rr][4] << "," << rr_stdev_array[rr][4] << "," << rr_pooled_array[rr][4]
-             << "," << mean_array[rr][4] << "," << stdev_array[rr][4];
-      if( weighted )
-        stream << "," << rr_wmean_array[rr][4] << "," << rr_wstdev_array[rr][4] << "," << rr_wpooled_array[rr][4]
-               << "," << wmean_array[rr][4] << "," << wstdev_array[rr][4];
-      stream << std::endl;
-
-      stream << "sample,female adult," << utilities::rr[rr]
-             << "," << total_summary.get_count( rr, ADULT, FEMALE, DISEASED )
-             << "," << total_summary.get_count( rr, ADULT, FEMALE )
-             << "," << rr_mean_array[rr][5] << "," << rr_stdev_array[rr][5] << "," << rr_pooled_array[rr][5]
-             << "," << mean_array[rr][5] << "," << stdev_array[rr][5];
-      if( weighted )
-        stream << "," << rr_wmean_array[rr][5] << "," << rr_wstdev_array[rr][5] << "," << rr_wpooled_array[rr][5]
-               << "," << wmean_array[rr][5] << "," << wstdev_array[rr][5];
-      stream << std::endl;
-
-      stream << "sample,male child," << utilities::rr[rr]
-             << "," << total_summary.get_count( rr, CHILD, MALE, DISEASED )
-             << "," << total_summary.get_count( rr, CHILD, MALE )
-             << "," << rr_mean_array[rr][7] << "," << rr_stdev_array[rr][7] << "," << rr_pooled_array[rr][7]
-             << "," << mean_array[rr][7] << "," << stdev_array[rr][7];
-      if( weighted )
-        stream << "," << rr_wmean_array[rr][7] << "," << rr_wstdev_array[rr][7] << "," << rr_wpooled_array[rr][7]
-               << "," << wmean_array[rr][7] << "," << wstdev_array[rr][7];
-      stream << std::endl;
-
-      stream << "sample,female child," << utilities::rr[rr]
-             << "," << total_summary.get_count( rr, CHILD, FEMALE, DISEASED )
-             << "," << total_summary.get_count( rr, CHILD, FEMALE )
-             << "," << rr_mean_array[rr][8] << "," << rr_stdev_array[rr][8] << "," << rr_pooled_array[rr][8]
-             << "," << mean_array[rr][8] << "," << stdev_array[rr][8];
-      if( weighted )
-        stream << "," << rr_wmean_array[rr][8] << "," << rr_wstdev_array[rr][8] << "," << rr_wpooled_array[rr][8]
-               << "," << wmean_array[rr][8] << "," << wstdev_array[rr][8];
-      stream << std::endl;
-    }
+    summary_accumulator accumulator( weighted );
+    for( auto it = summary_list.cbegin(); it != summary_list.cend(); ++it ) accumulator.add( *it );
+    accumulator.write( stream );
   }
 }
@@ -12,6 +12,7 @@
 #include "base_object.h"
 #include "utilities.h"
 
+#include <array>
 #include <vector>
 
 namespace Json { class Value; }
@@ -48,20 +49,33 @@ namespace sampsim
     /**
      * Adds a summary's totals to this one
      */
-    void add( summary* );
+    void add( const summary* );
 
     /**
      * Adds a model's summary totals to this one
      */
     void add( model_object* );
 
+    /**
+     * Serializes the summary's counts (along with the relative risks they were counted for)
+     */
+    void to_json( Json::Value& ) const;
+
+    /**
+     * Deserializes the summary's counts
+     * 
+     * Returns false (leaving the summary unchanged) if the counts were made for a different list of
+     * relative risks than the one currently in use.
+     */
+    bool from_json( const Json::Value& );
+
     /**
      * Writes the summary to a text file
      */
     void write( std::ostream& ) const;
 
     /**
-     * Writes the summary of a list of summaries to a text file
+     * Writes the summary of a list of summaries to a text file (see summary_accumulator)
      */
     static void write( std::vector< summary* >, bool weighted, std::ostream& );
 
@@ -170,6 +184,45 @@ namespace sampsim
       child_female_diseased_exposed
     };
 
+    /**
+     * The number of marginal counts (any, or one of two values, for each of age, sex, state and exposure)
+     */
+    static const unsigned int NUMBER_OF_MARGINALS = 81;
+
+    /**
+     * Converts age/sex/state/exposure values into a marginal index
+     * 
+     * Each type's values are ordered ANY, then its two specific values, so the index is simply the
+     * enum values (less the UNKNOWN value) in base 3.  Returns -1 if any of the values is unknown.
+     */
+    static int get_marginal_index(
+      const age_type age, const sex_type sex, const state_type state, const exposure_type exposure )
+    {
+      if( UNKNOWN_AGE_TYPE == age || UNKNOWN_SEX_TYPE == sex ||
+          UNKNOWN_STATE_TYPE == state || UNKNOWN_EXPOSURE_TYPE == exposure ) return -1;
+      return 27 * ( age - ANY_AGE ) + 9 * ( sex - ANY_SEX ) + 3 * ( state - ANY_STATE ) +
+             ( exposure - ANY_EXPOSURE );
+    }
+
+    /**
+     * @struct marginal_type
+     * @brief The (ascending) indices of all individual count values included in a marginal count
+     */
+    struct marginal_type
+    {
+      unsigned int size;
+      unsigned char index[16];
+    };
+
+    /**
+     * Returns the list of every marginal count, indexed by get_marginal_index()
+     * 
+     * The list is built once and shared by all summaries so that getting a count only requires adding
+     * up the values it includes rather than testing every value.  Values are added in the same order as
+     * they are stored so weighted totals don't depend on how they are looked up.
+     */
+    static const std::array< marginal_type, NUMBER_OF_MARGINALS >& get_marginal_list();
+
     /**
      * Converts age/sex/state/exposure values into a count index
      */
@@ -184,20 +237,15 @@ namespace sampsim
       return index;
     }
 
-    /**
-     * A list of all child summaries added to this summary
-     */
-    std::vector< summary* > child_list;
-
     /**
      * Individual count values
      */
-    std::vector< std::array< unsigned, 16 > > count;
+    std::array< std::array< unsigned, 16 >, SAMPSIM_MAXIMUM_RR > count;
 
     /**
      * Individual weighted count values
      */
-    std::vector< std::array< double, 16 > > weighted_count;
+    std::array< std::array< double, 16 >, SAMPSIM_MAXIMUM_RR > weighted_count;
   };
 }
 
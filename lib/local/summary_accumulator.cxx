@@ -0,0 +1,126 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   summary_accumulator.cxx
+  Language: C++
+
+=========================================================================*/
+
+#include "summary_accumulator.h"
+
+#include <cmath>
+
+namespace sampsim
+{
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  summary_accumulator::summary_accumulator( const bool weighted )
+  {
+    this->reset( weighted );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void summary_accumulator::reset( const bool weighted )
+  {
+    this->weighted = weighted;
+    this->number_of_summaries = 0;
+    this->total.reset();
+    this->group_list.clear();
+    this->group_list.resize( utilities::rr.size() );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void summary_accumulator::get_group_types( const unsigned int group, age_type &age, sex_type &sex )
+  {
+    age = 3 > group ? ANY_AGE : 6 > group ? ADULT : CHILD;
+    sex = 0 == group % 3 ? ANY_SEX : 1 == group % 3 ? MALE : FEMALE;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void summary_accumulator::add( const summary *sum )
+  {
+    this->number_of_summaries++;
+    this->total.add( sum );
+
+    age_type a;
+    sex_type s;
+    double val;
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+    {
+      for( unsigned int index = 0; index < NUMBER_OF_GROUPS; index++ )
+      {
+        summary_accumulator::get_group_types( index, a, s );
+        group_type &group = this->group_list[rr][index];
+
+        group.prevalence.add( sum->get_count_fraction( rr, a, s ) );
+        val = sum->get_relative_risk( rr, a, s );
+        if( !std::isinf( val ) ) group.relative_risk.add( val ); // don't include infinite rrs
+        group.pooled_numerator += sum->get_pooled_risk_numerator( rr, a, s );
+        group.pooled_denominator += sum->get_pooled_risk_denominator( rr, a, s );
+
+        if( this->weighted )
+        {
+          group.weighted_prevalence.add( sum->get_weighted_count_fraction( rr, a, s ) );
+          val = sum->get_weighted_relative_risk( rr, a, s );
+          if( !std::isinf( val ) ) group.weighted_relative_risk.add( val );
+          group.weighted_pooled_numerator += sum->get_weighted_pooled_risk_numerator( rr, a, s );
+          group.weighted_pooled_denominator += sum->get_weighted_pooled_risk_denominator( rr, a, s );
+        }
+      }
+    }
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void summary_accumulator::write( std::ostream &stream ) const
+  {
+    stream << "type,group,individual_rr,diseased,total,rr,rr_stdev,rr_pooled,prevalence,stdev";
+    if( this->weighted ) stream << ",wrr,wrr_stdev,wrr_pooled,wprevalence,wstdev";
+    stream << std::endl;
+
+    // groups are written in a different order than they are indexed
+    const unsigned int order[] = { 0, 3, 6, 1, 2, 4, 5, 7, 8 };
+    const char* name[] = {
+      "total", "male", "female", "adult", "male adult", "female adult", "child", "male child", "female child"
+    };
+
+    // the prevalence's standard deviation is measured from the prevalence of all summaries combined
+    // rather than from the mean prevalence, so the Welford sum of squares is adjusted by the difference
+    const unsigned int n = this->number_of_summaries;
+    auto get_stdev = [n]( const statistic_type &statistic, const double mean )
+    {
+      double diff = statistic.mean - mean;
+      double squared_sum = 0 == n ? 0 : statistic.squared_sum + n * diff * diff;
+      return sqrt( squared_sum / static_cast< double >( n - 1 ) );
+    };
+
+    age_type a;
+    sex_type s;
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+    {
+      for( unsigned int o = 0; o < NUMBER_OF_GROUPS; o++ )
+      {
+        unsigned int index = order[o];
+        summary_accumulator::get_group_types( index, a, s );
+        const group_type &group = this->group_list[rr][index];
+
+        double mean = this->total.get_count_fraction( rr, a, s );
+        stream << "sample," << name[index] << "," << utilities::rr[rr]
+               << "," << this->total.get_count( rr, a, s, DISEASED )
+               << "," << this->total.get_count( rr, a, s )
+               << "," << group.relative_risk.sum / group.relative_risk.count
+               << "," << sqrt( group.relative_risk.squared_sum / group.relative_risk.count )
+               << "," << group.pooled_numerator / group.pooled_denominator
+               << "," << mean << "," << get_stdev( group.prevalence, mean );
+
+        if( this->weighted )
+        {
+          double wmean = this->total.get_weighted_count_fraction( rr, a, s );
+          stream << "," << group.weighted_relative_risk.sum / group.weighted_relative_risk.count
+                 << "," << sqrt( group.weighted_relative_risk.squared_sum / group.weighted_relative_risk.count )
+                 << "," << group.weighted_pooled_numerator / group.weighted_pooled_denominator
+                 << "," << wmean << "," << get_stdev( group.weighted_prevalence, wmean );
+        }
+        stream << std::endl;
+      }
+    }
+  }
+}
@@ -0,0 +1,135 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   summary_accumulator.h
+  Language: C++
+
+=========================================================================*/
+
+#ifndef __sampsim_summary_accumulator_h
+#define __sampsim_summary_accumulator_h
+
+#include "summary.h"
+
+#include <array>
+#include <ostream>
+#include <vector>
+
+/**
+ * @addtogroup sampsim
+ * @{
+ */
+
+namespace sampsim
+{
+  /**
+   * @class summary_accumulator
+   * @author Patrick Emond <emondpd@mcmaster.ca>
+   * @brief Accumulates the statistics of many sample summaries one summary at a time
+   * @details
+   * Each sample iteration's summary is added as soon as it is available, after which the summary (and
+   * the sampled population it belongs to) is no longer needed.  Relative risks and prevalences are
+   * determined once per summary and their means and variances are tracked using Welford's algorithm
+   * so that any number of summaries can be written in a single pass.  The written columns are the
+   * same as those of summary::write().
+   */
+  class summary_accumulator
+  {
+  public:
+    /**
+     * Constructor
+     */
+    summary_accumulator( const bool weighted = false );
+
+    /**
+     * Removes all accumulated summaries and sets whether weighted statistics are accumulated
+     */
+    void reset( const bool weighted );
+
+    /**
+     * Adds a summary's statistics to the accumulator
+     */
+    void add( const summary* );
+
+    /**
+     * Returns the number of summaries which have been added
+     */
+    unsigned int get_number_of_summaries() const { return this->number_of_summaries; }
+
+    /**
+     * Writes the accumulated statistics to a text file
+     */
+    void write( std::ostream& ) const;
+
+    /**
+     * @struct statistic_type
+     * @brief A running sum, mean and sum of squared differences from the mean (Welford's algorithm)
+     */
+    struct statistic_type
+    {
+      statistic_type() : count( 0 ), sum( 0 ), mean( 0 ), squared_sum( 0 ) {}
+      void add( const double value )
+      {
+        double diff = value - this->mean;
+        this->count++;
+        this->sum += value;
+        this->mean += diff / this->count;
+        this->squared_sum += diff * ( value - this->mean );
+      }
+
+      unsigned int count;
+      double sum;
+      double mean;
+      double squared_sum;
+    };
+
+  private:
+    /**
+     * @struct group_type
+     * @brief The statistics of one rr, age and sex group (weighted statistics are only used when
+     *        the accumulator is weighted)
+     */
+    struct group_type
+    {
+      group_type() : pooled_numerator( 0 ), pooled_denominator( 0 ),
+                     weighted_pooled_numerator( 0 ), weighted_pooled_denominator( 0 ) {}
+
+      statistic_type prevalence, relative_risk, weighted_prevalence, weighted_relative_risk;
+      double pooled_numerator, pooled_denominator, weighted_pooled_numerator, weighted_pooled_denominator;
+    };
+
+    /**
+     * The number of age/sex groups (any, adult and child by any, male and female)
+     */
+    static const unsigned int NUMBER_OF_GROUPS = 9;
+
+    /**
+     * Converts a group index into its age and sex types
+     */
+    static void get_group_types( const unsigned int group, age_type &age, sex_type &sex );
+
+    /**
+     * Whether weighted statistics are accumulated
+     */
+    bool weighted;
+
+    /**
+     * The number of summaries which have been added
+     */
+    unsigned int number_of_summaries;
+
+    /**
+     * The sum of all added summaries
+     */
+    summary total;
+
+    /**
+     * The statistics of every group, indexed by rr
+     */
+    std::vector< std::array< group_type, NUMBER_OF_GROUPS > > group_list;
+  };
+}
+
+/** @} end of doxygen group */
+
+#endif
@@ -12,10 +12,48 @@
 
 #include "UnitTest++.h"
 
+#include "base_object.h"
+#include "utilities.h"
+
+using namespace std;
+
 int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
 
+// a minimal concrete object used to test the debug macros
+class test_object : public sampsim::base_object
+{
+public:
+  test_object() : evaluated( 0 ) {}
+  std::string get_name() const { return "test_object"; }
+  void copy( const sampsim::base_object* ) {}
+  void from_json( const Json::Value& ) {}
+  void to_json( Json::Value& ) const {}
+  void to_csv( std::ostream&, std::ostream& ) const {}
+
+  void log()
+  {
+    SAMPSIM_DEBUG( "debug %d", this->count() );
+    SAMPSIM_TRACE( "trace %d", this->count() );
+  }
+
+  int count() { return ++this->evaluated; }
+  int evaluated;
+};
+
 TEST( test_base_object )
 {
-  // no tests to perform for this class
-  CHECK( true );
+  bool quiet = sampsim::utilities::quiet;
+  sampsim::utilities::quiet = true;
+
+  cout << "Testing that debug arguments are not evaluated when debug mode is off..." << endl;
+  test_object object;
+  object.log();
+  CHECK_EQUAL( 0, object.evaluated );
+
+  cout << "Testing that debug arguments are evaluated when debug mode is on..." << endl;
+  object.debug_mode = true;
+  object.log();
+  CHECK_EQUAL( ( 1 <= SAMPSIM_DEBUG_LEVEL ? 1 : 0 ) + ( 2 <= SAMPSIM_DEBUG_LEVEL ? 1 : 0 ), object.evaluated );
+
+  sampsim::utilities::quiet = quiet;
 }
@@ -0,0 +1,99 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   test_cluster_variance.cxx
+  Language: C++
+
+=========================================================================*/
+//
+// .SECTION Description
+// Unit tests for the cluster_variance class
+//
+
+#include "UnitTest++.h"
+
+#include "cluster_variance.h"
+#include "utilities.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
+
+TEST( test_cluster_variance )
+{
+  // create clusters with random numbers of selected and diseased individuals
+  vector< double > selected_list, diseased_list;
+  sampsim::cluster_variance clusters;
+  for( unsigned int c = 0; c < 40; c++ )
+  {
+    double selected = sampsim::utilities::random( 10, 60 );
+    double diseased = floor( selected * sampsim::utilities::random() );
+    selected_list.push_back( selected );
+    diseased_list.push_back( diseased );
+    clusters.add_cluster( selected, diseased );
+  }
+  const double n = selected_list.size();
+  CHECK_EQUAL( n, clusters.get_number_of_clusters() );
+
+  double sum_m = 0, sum_y = 0;
+  for( unsigned int c = 0; c < n; c++ )
+  {
+    sum_m += selected_list[c];
+    sum_y += diseased_list[c];
+  }
+  const double proportion = sum_y / sum_m;
+
+  cout << "Testing the proportion and ratio variance..." << endl;
+  CHECK_CLOSE( proportion, clusters.get_proportion(), 1e-12 );
+  double sum_residual = 0;
+  for( unsigned int c = 0; c < n; c++ )
+    sum_residual += pow( diseased_list[c] - proportion * selected_list[c], 2 );
+  double ratio = sum_residual / ( n * ( n - 1 ) * pow( sum_m / n, 2 ) );
+  CHECK_CLOSE( ratio, clusters.get_ratio_variance(), 1e-9 * ratio );
+
+  cout << "Testing the jackknife variance against deleting each cluster..." << endl;
+  vector< double > estimate_list;
+  for( unsigned int d = 0; d < n; d++ )
+  {
+    sampsim::cluster_variance deleted;
+    for( unsigned int c = 0; c < n; c++ ) if( c != d ) deleted.add_cluster( selected_list[c], diseased_list[c] );
+    estimate_list.push_back( deleted.get_proportion() );
+  }
+  double mean = 0, jackknife = 0;
+  for( unsigned int d = 0; d < n; d++ ) mean += estimate_list[d] / n;
+  for( unsigned int d = 0; d < n; d++ ) jackknife += ( n - 1 ) / n * pow( estimate_list[d] - mean, 2 );
+  CHECK_CLOSE( jackknife, clusters.get_jackknife_variance(), 1e-9 * jackknife );
+
+  cout << "Testing the bootstrap variance..." << endl;
+  double bootstrap = clusters.get_bootstrap_variance( 1000, 1234 );
+  CHECK_EQUAL( bootstrap, clusters.get_bootstrap_variance( 1000, 1234, 4 ) );
+  CHECK( bootstrap != clusters.get_bootstrap_variance( 1000, 4321 ) );
+  CHECK_CLOSE( ratio, bootstrap, 0.25 * ratio );
+
+  cout << "Testing the design effect and intra-cluster correlation..." << endl;
+  double deff = ratio / ( proportion * ( 1 - proportion ) / sum_m );
+  CHECK_CLOSE( deff, clusters.get_design_effect(), 1e-9 * deff );
+  CHECK_CLOSE( ( deff - 1 ) / ( sum_m / n - 1 ), clusters.get_intracluster_correlation(), 1e-9 );
+  CHECK_CLOSE( sum_m / deff, clusters.get_effective_sample_size(), 1e-9 * sum_m );
+
+  cout << "Testing too few clusters..." << endl;
+  sampsim::cluster_variance single;
+  single.add_cluster( selected_list[0], diseased_list[0] );
+  CHECK( std::isnan( single.get_ratio_variance() ) );
+  CHECK( std::isnan( single.get_jackknife_variance() ) );
+  CHECK( std::isnan( single.get_bootstrap_variance( 100, 1 ) ) );
+  CHECK( std::isnan( single.get_design_effect() ) );
+  CHECK( std::isnan( single.get_intracluster_correlation() ) );
+  CHECK( std::isnan( single.get_effective_sample_size() ) );
+  clusters.clear();
+  CHECK_EQUAL( 0, clusters.get_number_of_clusters() );
+
+  cout << "Testing clusters of single individuals..." << endl;
+  sampsim::cluster_variance singletons;
+  for( unsigned int c = 0; c < 10; c++ ) singletons.add_cluster( 1, c % 2 );
+  CHECK_CLOSE( 10.0 / 9.0, singletons.get_design_effect(), 1e-9 ); // n / ( n - 1 ) for independent draws
+  CHECK( std::isnan( singletons.get_intracluster_correlation() ) );
+}
@@ -0,0 +1,79 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   test_csv_writer.cxx
+  Language: C++
+
+=========================================================================*/
+//
+// .SECTION Description
+// Unit tests for the csv_writer class
+//
+
+#include "UnitTest++.h"
+
+#include "csv_writer.h"
+#include "utilities.h"
+
+#include <limits>
+#include <random>
+#include <sstream>
+
+using namespace std;
+
+int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
+
+TEST( test_csv_writer )
+{
+  cout << "Testing integer and string formatting..." << endl;
+  sampsim::csv_writer writer;
+  writer << 0 << ',' << 7 << ',' << -12 << ',' << 4294967295U << ','
+         << numeric_limits< long long >::min() << ',' << "text" << ',' << string( "string" );
+  CHECK_EQUAL( "0,7,-12,4294967295,-9223372036854775808,text,string", writer.str() );
+
+  cout << "Testing enum formatting..." << endl;
+  writer.clear();
+  CHECK_EQUAL( 0, writer.size() );
+  writer << sampsim::ADULT << ',' << sampsim::CHILD << ',' << sampsim::FEMALE << ',' << sampsim::MALE;
+  stringstream enum_stream;
+  enum_stream << sampsim::get_age_type_name( sampsim::ADULT ) << ","
+              << sampsim::get_age_type_name( sampsim::CHILD ) << ","
+              << sampsim::get_sex_type_name( sampsim::FEMALE ) << ","
+              << sampsim::get_sex_type_name( sampsim::MALE );
+  CHECK_EQUAL( enum_stream.str(), writer.str() );
+
+  cout << "Testing that doubles are written the same as std::ostream..." << endl;
+  std::mt19937 engine( 1 );
+  std::uniform_real_distribution< double > uniform( -1e3, 1e3 );
+  std::exponential_distribution< double > exponential( 1e-4 );
+  vector< double > value_list = { 0.0, -0.0, 1.0, -3.0, 0.5, 1e6, 999999.0, 123456.5, 1e-5, 1.0/3.0, 2e300 };
+  for( int i = 0; i < 1000; i++ ) value_list.push_back( uniform( engine ) );
+  for( int i = 0; i < 1000; i++ ) value_list.push_back( exponential( engine ) );
+  for( int i = 0; i < 1000; i++ ) value_list.push_back( floor( exponential( engine ) ) );
+
+  for( auto it = value_list.cbegin(); it != value_list.cend(); ++it )
+  {
+    writer.clear();
+    writer << *it;
+    stringstream stream;
+    stream << *it;
+    CHECK_EQUAL( stream.str(), writer.str() );
+
+    writer.clear();
+    writer << sampsim::csv_writer::fixed( *it, 3 );
+    stream.str( "" );
+    stream.precision( 3 );
+    stream << std::fixed << *it;
+    CHECK_EQUAL( stream.str(), writer.str() );
+  }
+
+  cout << "Testing appending and taking the buffer..." << endl;
+  sampsim::csv_writer first, second;
+  first << "a,b" << '\n';
+  second << 1 << ',' << 2.5 << '\n';
+  first << second;
+  CHECK_EQUAL( "a,b\n1,2.5\n", first.str() );
+  string contents = first.take();
+  CHECK_EQUAL( "a,b\n1,2.5\n", contents );
+  CHECK_EQUAL( 0, first.size() );
+}
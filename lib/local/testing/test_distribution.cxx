@@ -15,12 +15,62 @@
 #include "distribution.h"
 #include "utilities.h"
 
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
 using namespace std;
 
 int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
 
 TEST( test_distribution )
 {
-  // no tests to perform for this class
-  CHECK( true );
+  sampsim::distribution dist;
+  vector< double > single_list( 1000 ), batch_list( 1000 );
+
+  cout << "Testing that generate_values matches generate_value..." << endl;
+  for( int type = sampsim::distribution::LOGNORMAL; type <= sampsim::distribution::WEIBULL; type++ )
+  {
+    if( sampsim::distribution::LOGNORMAL == type ) dist.set_lognormal( 1.0, 0.5 );
+    else if( sampsim::distribution::NORMAL == type ) dist.set_normal( 2.0, 3.0 );
+    else if( sampsim::distribution::PARETO == type ) dist.set_pareto( 1.0, 2.0, 50.0 );
+    else if( sampsim::distribution::POISSON == type ) dist.set_poisson( 4.0 );
+    else if( sampsim::distribution::WEIBULL == type ) dist.set_weibull( 1.5, 2.0 );
+
+    sampsim::utilities::random_engine.seed( type );
+    for( auto it = single_list.begin(); it != single_list.end(); ++it ) *it = dist.generate_value();
+    sampsim::utilities::random_engine.seed( type );
+    dist.generate_values( batch_list.size(), batch_list.data() );
+    CHECK( single_list == batch_list );
+  }
+
+  cout << "Testing integer values..." << endl;
+  vector< int > int_list( 1000 );
+  sampsim::utilities::random_engine.seed( 1 );
+  dist.set_poisson( 4.0 );
+  dist.generate_values( int_list.size(), int_list.data() );
+  sampsim::utilities::random_engine.seed( 1 );
+  for( unsigned int i = 0; i < int_list.size(); i++ )
+    CHECK_EQUAL( static_cast< int >( dist.generate_value() ), int_list[i] );
+
+  cout << "Testing independent normal values..." << endl;
+  sampsim::utilities::random_engine.seed( 2 );
+  for( unsigned int i = 0; i < single_list.size(); i++ )
+  {
+    sampsim::distribution fresh;
+    if( 0 == i % 2 ) fresh.set_normal( 3.0, 2.0 );
+    else fresh.set_lognormal( 3.0, 2.0 );
+    single_list[i] = fresh.generate_value();
+  }
+  sampsim::utilities::random_engine.seed( 2 );
+  sampsim::distribution::generate_independent_normal_values( batch_list.size(), batch_list.data() );
+  for( unsigned int i = 0; i < batch_list.size(); i++ )
+  {
+    double value = batch_list[i] * 2.0 + 3.0;
+    CHECK_EQUAL( single_list[i], 0 == i % 2 ? value : exp( value ) );
+  }
+
+  cout << "Testing an unknown distribution..." << endl;
+  sampsim::distribution unknown;
+  CHECK_THROW( unknown.generate_values( batch_list.size(), batch_list.data() ), std::runtime_error );
 }
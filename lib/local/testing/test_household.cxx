@@ -59,6 +59,13 @@ TEST( test_household )
           sum = household->get_summary();
           for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ ) CHECK( 0 != sum->get_count( rr ) );
 
+          cout << "Testing household member counts..." << endl;
+          for( age_type age : { ANY_AGE, ADULT, CHILD } )
+            for( sex_type sex : { ANY_SEX, MALE, FEMALE } )
+              CHECK_EQUAL( sum->get_count( 0, age, sex ), household->get_number_of_members( age, sex ) );
+          CHECK_EQUAL( household->get_number_of_individuals(),
+                       household->get_number_of_members( ANY_AGE, ANY_SEX ) );
+
           cout << "Turning on sample mode" << endl;
           population->set_sample_mode( true );
 
@@ -77,6 +84,10 @@ TEST( test_household )
             CHECK_EQUAL( 0, sum->get_count( rr, CHILD, FEMALE ) );
           }
 
+          cout << "Testing that member counts include unselected individuals..." << endl;
+          CHECK_EQUAL( household->get_number_of_individuals(),
+                       household->get_number_of_members( ANY_AGE, ANY_SEX ) );
+
           cout << "Testing that household with selected individual has population..." << endl;
           individual->select();
           sum = household->get_summary();
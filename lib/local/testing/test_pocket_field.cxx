@@ -0,0 +1,76 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   test_pocket_field.cxx
+  Language: C++
+
+=========================================================================*/
+//
+// .SECTION Description
+// Unit tests for the pocket_field class
+//
+
+#include "UnitTest++.h"
+
+#include "coordinate.h"
+#include "pocket_field.h"
+#include "utilities.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
+
+TEST( test_pocket_field )
+{
+  vector< sampsim::coordinate > pocket_list, position_list;
+  for( int i = 0; i < 300; ++i )
+    pocket_list.push_back( sampsim::coordinate( 10 * sampsim::utilities::random(),
+                                                10 * sampsim::utilities::random() ) );
+  for( int i = 0; i < 500; ++i )
+    position_list.push_back( sampsim::coordinate( 10 * sampsim::utilities::random(),
+                                                  10 * sampsim::utilities::random() ) );
+
+  const double scaling = 0.2;
+  const string kernel_list[] = { "exponential", "inverse_square", "gaussian" };
+  sampsim::pocket_field field;
+  for( unsigned int k = 0; k < 3; k++ )
+  {
+    cout << "Testing the " << kernel_list[k] << " kernel..." << endl;
+    sampsim::pocket_field cutoff_field, large_cutoff_field;
+    field.set_pockets( pocket_list, kernel_list[k], scaling );
+    cutoff_field.set_pockets( pocket_list, kernel_list[k], scaling, 5 );
+    large_cutoff_field.set_pockets( pocket_list, kernel_list[k], scaling, 1000 );
+    CHECK_EQUAL( pocket_list.size(), field.get_number_of_pockets() );
+
+    for( auto position = position_list.cbegin(); position != position_list.cend(); ++position )
+    {
+      // sum the kernel over all pockets the way buildings used to
+      double factor = 0.0, cutoff_factor = 0.0;
+      for( auto it = pocket_list.cbegin(); it != pocket_list.cend(); ++it )
+      {
+        double distance = position->distance( *it ) / scaling;
+        double value = 0 == k ? exp( -distance ) :
+                       1 == k ? 1 / ( distance * distance ) :
+                                exp( -( distance * distance ) );
+        factor += value;
+        if( distance <= 5 ) cutoff_factor += value;
+      }
+
+      CHECK_EQUAL( factor, field.get_factor( *position ) );
+      CHECK_EQUAL( factor, large_cutoff_field.get_factor( *position ) );
+      CHECK_CLOSE( cutoff_factor, cutoff_field.get_factor( *position ), 1e-9 * cutoff_factor );
+    }
+  }
+
+  cout << "Testing an empty field..." << endl;
+  field.set_pockets( vector< sampsim::coordinate >(), "exponential", scaling, 5 );
+  CHECK_EQUAL( 0.0, field.get_factor( position_list[0] ) );
+
+  cout << "Testing invalid parameters..." << endl;
+  CHECK_THROW( field.set_pockets( pocket_list, "unknown", scaling ), std::runtime_error );
+  CHECK_THROW( field.set_pockets( pocket_list, "gaussian", scaling, -1 ), std::runtime_error );
+}
@@ -21,6 +21,8 @@
 #include "tile.h"
 #include "town.h"
 
+#include <thread>
+
 int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
 
 TEST( test_population )
@@ -226,6 +228,71 @@ TEST( test_population )
     CHECK_EQUAL( sum->get_count( rr, CHILD, FEMALE, HEALTHY ), read_sum->get_count( rr, CHILD, FEMALE, HEALTHY ) );
   }
 
+  cout << "Testing that reading with different relative risks fails..." << endl;
+  std::vector< double > rr_list( utilities::rr.begin(), utilities::rr.end() );
+  std::vector< double > other_rr_list = rr_list;
+  other_rr_list.back() += 1;
+  utilities::set_rr( other_rr_list );
+  sampsim::population *population_other_rr = new sampsim::population;
+  CHECK( !population_other_rr->read( temp_filename.str() ) );
+  utilities::safe_delete( population_other_rr );
+  utilities::set_rr( rr_list );
+
+  cout << "Testing redefining a population using its existing geometry..." << endl;
+  sampsim::population *parameters = new sampsim::population;
+  parameters->copy( population_read );
+  parameters->set_target_prevalence( 0.9 );
+  sampsim::building *read_building = *( *population_read->get_town_list_begin() )->
+    get_tile_list_begin()->second->get_building_list_begin();
+  sampsim::coordinate position = read_building->get_position();
+  unsigned int diseased = population_read->get_summary()->get_count( 0, ANY_AGE, ANY_SEX, DISEASED );
+  population_read->redefine( parameters );
+  CHECK_EQUAL( population->get_number_of_individuals(), population_read->get_number_of_individuals() );
+  CHECK_EQUAL( position.x, read_building->get_position().x );
+  CHECK_EQUAL( position.y, read_building->get_position().y );
+  CHECK( diseased < population_read->get_summary()->get_count( 0, ANY_AGE, ANY_SEX, DISEASED ) );
+  sampsim::utilities::safe_delete( parameters );
+
+  cout << "Testing writing the population summary from the file's header..." << endl;
+  stringstream summary_filename;
+  summary_filename << "/tmp/sampsim" << random1;
+  population->write_summary( summary_filename.str() + ".full" );
+  CHECK( sampsim::population::write_summary_from_header( temp_filename.str(), summary_filename.str() + ".header" ) );
+  CHECK_EQUAL(
+    sampsim::utilities::exec( "cat " + summary_filename.str() + ".full.csv" ),
+    sampsim::utilities::exec( "cat " + summary_filename.str() + ".header.csv" ) );
+
+  cout << "Testing generating a population one town at a time..." << endl;
+  sampsim::population *streamed = new sampsim::population;
+  streamed->copy( population );
+  streamed->set_number_of_towns( 3 );
+  streamed->set_seed( "1234" );
+  streamed->generate();
+  std::string hash = streamed->get_content_hash();
+  unsigned int count = streamed->get_summary()->get_count( 0, ANY_AGE, ANY_SEX, DISEASED );
+  streamed->set_seed( "1234" );
+  streamed->generate_streaming( summary_filename.str() + ".streamed" );
+  CHECK_EQUAL( count, streamed->get_summary()->get_count( 0, ANY_AGE, ANY_SEX, DISEASED ) );
+  CHECK( streamed->read( summary_filename.str() + ".streamed.json.tar.gz" ) );
+  CHECK_EQUAL( 3, streamed->get_number_of_towns() );
+  CHECK_EQUAL( hash, streamed->get_content_hash() );
+
+  cout << "Testing generating only a population's summary..." << endl;
+  streamed->set_seed( "1234" );
+  streamed->generate_summary();
+  CHECK_EQUAL( count, streamed->get_summary()->get_count( 0, ANY_AGE, ANY_SEX, DISEASED ) );
+  CHECK( streamed->get_town_list_cbegin() == streamed->get_town_list_cend() );
+
+  cout << "Testing generating a copy of a population's parameters in another thread..." << endl;
+  sampsim::population *threaded = new sampsim::population;
+  threaded->copy_parameters( streamed );
+  CHECK_EQUAL( 3, threaded->get_number_of_towns() );
+  std::thread thread( [threaded]() { threaded->set_seed( "1234" ); threaded->generate(); } );
+  thread.join();
+  CHECK_EQUAL( hash, threaded->get_content_hash() );
+  sampsim::utilities::safe_delete( threaded );
+  sampsim::utilities::safe_delete( streamed );
+
   // clean up
   command.str( "" );
   command.clear();
@@ -0,0 +1,145 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   test_stratified_summary.cxx
+  Language: C++
+
+=========================================================================*/
+//
+// .SECTION Description
+// Unit tests for the stratified_summary class
+//
+
+#include "UnitTest++.h"
+
+#include "building.h"
+#include "common.h"
+#include "household.h"
+#include "individual.h"
+#include "population.h"
+#include "stratified_summary.h"
+#include "summary.h"
+#include "tile.h"
+#include "town.h"
+#include "utilities.h"
+
+#include <stdexcept>
+
+int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
+
+TEST( test_stratified_summary )
+{
+  // create a population
+  sampsim::population *population = new sampsim::population;
+  create_test_population( population, 2, 5000, 20000 );
+  sampsim::summary *sum = population->get_summary();
+
+  cout << "Testing an unstratified summary..." << endl;
+  sampsim::stratified_summary cube;
+  CHECK_EQUAL( 1, cube.get_number_of_cells() );
+  cube.add( population );
+  for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+  {
+    CHECK_EQUAL( sum->get_count( rr ), cube.get_cell( {} )->get_count( rr ) );
+    CHECK_EQUAL( sum->get_count( rr, CHILD, FEMALE, DISEASED ),
+                 cube.get_cell( {} )->get_count( rr, CHILD, FEMALE, DISEASED ) );
+  }
+
+  cout << "Testing invalid dimensions..." << endl;
+  CHECK_THROW(
+    cube.add_dimension( sampsim::stratified_summary::HOUSEHOLD_SIZE, { 4, 2 } ), std::runtime_error );
+  CHECK_THROW(
+    cube.add_dimension( sampsim::stratified_summary::UNKNOWN_DIMENSION_TYPE, { 1 } ), std::runtime_error );
+
+  cout << "Testing the shape of the cube..." << endl;
+  cube.add_dimension( sampsim::stratified_summary::INCOME_QUANTILE, { 0.25, 0.5, 0.75 } );
+  cube.add_dimension( sampsim::stratified_summary::HOUSEHOLD_SIZE, { 2, 4 } );
+  cube.add_dimension( sampsim::stratified_summary::POCKET_DISTANCE, { 0.5 } );
+  CHECK_THROW( cube.add_dimension( sampsim::stratified_summary::HOUSEHOLD_SIZE, { 3 } ), std::runtime_error );
+  CHECK_EQUAL( 3, cube.get_number_of_dimensions() );
+  CHECK_EQUAL( 4 * 3 * 2, cube.get_number_of_cells() );
+  CHECK_EQUAL( 0, cube.get_cell( { 0, 0, 0 } )->get_count( 0 ) );
+
+  cout << "Testing that the strata add up to the population..." << endl;
+  cube.add( population );
+  for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+  {
+    unsigned int total = 0, diseased = 0;
+    for( unsigned int i = 0; i < 4; i++ )
+      for( unsigned int s = 0; s < 3; s++ )
+        for( unsigned int p = 0; p < 2; p++ )
+        {
+          total += cube.get_cell( { i, s, p } )->get_count( rr );
+          diseased += cube.get_cell( { i, s, p } )->get_count( rr, ANY_AGE, ANY_SEX, DISEASED );
+        }
+    CHECK_EQUAL( sum->get_count( rr ), total );
+    CHECK_EQUAL( sum->get_count( rr, ANY_AGE, ANY_SEX, DISEASED ), diseased );
+  }
+
+  cout << "Testing household size strata..." << endl;
+  unsigned int small = 0, medium = 0, large = 0;
+  for( auto town_it = population->get_town_list_begin();
+       town_it != population->get_town_list_end();
+       ++town_it )
+    for( auto tile_it = (*town_it)->get_tile_list_begin();
+         tile_it != (*town_it)->get_tile_list_end();
+         ++tile_it )
+      for( auto b_it = tile_it->second->get_building_list_begin();
+           b_it != tile_it->second->get_building_list_end();
+           ++b_it )
+        for( auto h_it = (*b_it)->get_household_list_begin();
+             h_it != (*b_it)->get_household_list_end();
+             ++h_it )
+        {
+          unsigned int size = (*h_it)->get_number_of_individuals();
+          if( 2 > size ) small += size;
+          else if( 4 > size ) medium += size;
+          else large += size;
+        }
+  CHECK_EQUAL( small, cube.get_marginal( 1, 0 ).get_count( 0 ) );
+  CHECK_EQUAL( medium, cube.get_marginal( 1, 1 ).get_count( 0 ) );
+  CHECK_EQUAL( large, cube.get_marginal( 1, 2 ).get_count( 0 ) );
+
+  cout << "Testing income quantile strata..." << endl;
+  for( unsigned int i = 0; i < 4; i++ ) CHECK( 0 < cube.get_marginal( 0, i ).get_count( 0 ) );
+
+  cout << "Testing adding cubes..." << endl;
+  sampsim::stratified_summary copy = cube;
+  copy.add( &cube );
+  CHECK_EQUAL( 2 * sum->get_count( 0 ), copy.get_marginal( 2, 0 ).get_count( 0 ) +
+                                        copy.get_marginal( 2, 1 ).get_count( 0 ) );
+  sampsim::stratified_summary other;
+  CHECK_THROW( copy.add( &other ), std::runtime_error );
+
+  cout << "Testing selected individuals only..." << endl;
+  sampsim::town *town = *population->get_town_list_begin();
+  sampsim::tile *tile = town->get_tile_list_begin()->second;
+  sampsim::household *household = *( *tile->get_building_list_begin() )->get_household_list_begin();
+  for( auto it = household->get_individual_list_begin(); it != household->get_individual_list_end(); ++it )
+    (*it)->select();
+  population->set_sample_mode( true );
+  cube.reset();
+  cube.add( population );
+  CHECK_EQUAL( household->get_number_of_individuals(), cube.get_marginal( 0, 0 ).get_count( 0 ) +
+                                                       cube.get_marginal( 0, 1 ).get_count( 0 ) +
+                                                       cube.get_marginal( 0, 2 ).get_count( 0 ) +
+                                                       cube.get_marginal( 0, 3 ).get_count( 0 ) );
+  population->set_sample_mode( false );
+
+  cout << "Testing writing the cube..." << endl;
+  stringstream stream;
+  cube.write( stream, "population" );
+  string line;
+  getline( stream, line );
+  CHECK_EQUAL( "type,income_quantile_min,income_quantile_max,household_size_min,household_size_max,"
+               "pocket_distance_min,pocket_distance_max,"
+               "group,individual_rr,diseased,total,rr,prevalence", line );
+  getline( stream, line );
+  string prefix = "population,-Inf,0.25,-Inf,2,-Inf,0.5,total,";
+  CHECK_EQUAL( prefix, line.substr( 0, prefix.size() ) );
+  unsigned int lines = 1;
+  while( getline( stream, line ) ) lines++;
+  CHECK_EQUAL( cube.get_number_of_cells() * utilities::rr.size() * 9, lines );
+
+  utilities::safe_delete( population );
+}
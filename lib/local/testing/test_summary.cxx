@@ -0,0 +1,94 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   test_summary.cxx
+  Language: C++
+
+=========================================================================*/
+//
+// .SECTION Description
+// Unit tests for the summary class
+//
+
+#include "UnitTest++.h"
+
+#include "summary.h"
+#include "utilities.h"
+
+#include <json/value.h>
+
+using namespace std;
+
+int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
+
+TEST( test_summary )
+{
+  // fill a summary with random counts
+  const unsigned int size = sampsim::utilities::rr.size();
+  unsigned int count[size][16];
+  double weighted_count[size][16];
+  Json::Value json( Json::objectValue );
+  json["rr"] = Json::Value( Json::arrayValue );
+  json["count"] = Json::Value( Json::arrayValue );
+  json["weighted_count"] = Json::Value( Json::arrayValue );
+  for( unsigned int rr = 0; rr < size; rr++ )
+  {
+    json["rr"].append( sampsim::utilities::rr[rr] );
+    Json::Value count_json( Json::arrayValue ), weighted_count_json( Json::arrayValue );
+    for( unsigned int i = 0; i < 16; i++ )
+    {
+      count[rr][i] = sampsim::utilities::random( 0, 1000 );
+      weighted_count[rr][i] = 100 * sampsim::utilities::random();
+      count_json.append( count[rr][i] );
+      weighted_count_json.append( weighted_count[rr][i] );
+    }
+    json["count"].append( count_json );
+    json["weighted_count"].append( weighted_count_json );
+  }
+
+  sampsim::summary sum;
+  CHECK( sum.from_json( json ) );
+
+  cout << "Testing every combination of age, sex, state and exposure..." << endl;
+  const sampsim::age_type age_list[] = { sampsim::ANY_AGE, sampsim::ADULT, sampsim::CHILD };
+  const sampsim::sex_type sex_list[] = { sampsim::ANY_SEX, sampsim::MALE, sampsim::FEMALE };
+  const sampsim::state_type state_list[] = { sampsim::ANY_STATE, sampsim::HEALTHY, sampsim::DISEASED };
+  const sampsim::exposure_type exposure_list[] =
+    { sampsim::ANY_EXPOSURE, sampsim::NOT_EXPOSED, sampsim::EXPOSED };
+  for( unsigned int rr = 0; rr < size; rr++ )
+  for( unsigned int a = 0; a < 3; a++ )
+  for( unsigned int s = 0; s < 3; s++ )
+  for( unsigned int d = 0; d < 3; d++ )
+  for( unsigned int e = 0; e < 3; e++ )
+  {
+    // add up the matching counts (in the order they are stored)
+    unsigned int expected = 0;
+    double weighted_expected = 0;
+    for( unsigned int i = 0; i < 16; i++ )
+    {
+      if( ( 0 == a || ( 8 & i ? sampsim::CHILD : sampsim::ADULT ) == age_list[a] ) &&
+          ( 0 == s || ( 4 & i ? sampsim::FEMALE : sampsim::MALE ) == sex_list[s] ) &&
+          ( 0 == d || ( 2 & i ? sampsim::DISEASED : sampsim::HEALTHY ) == state_list[d] ) &&
+          ( 0 == e || ( 1 & i ? sampsim::EXPOSED : sampsim::NOT_EXPOSED ) == exposure_list[e] ) )
+      {
+        expected += count[rr][i];
+        weighted_expected += weighted_count[rr][i];
+      }
+    }
+
+    CHECK_EQUAL( expected, sum.get_count( rr, age_list[a], sex_list[s], state_list[d], exposure_list[e] ) );
+    CHECK_EQUAL( weighted_expected,
+                 sum.get_weighted_count( rr, age_list[a], sex_list[s], state_list[d], exposure_list[e] ) );
+  }
+
+  cout << "Testing unknown types..." << endl;
+  CHECK_EQUAL( 0, sum.get_count( 0, sampsim::UNKNOWN_AGE_TYPE ) );
+  CHECK_EQUAL( 0.0, sum.get_weighted_count( 0, sampsim::ANY_AGE, sampsim::UNKNOWN_SEX_TYPE ) );
+
+  cout << "Testing adding summaries..." << endl;
+  sampsim::summary total;
+  total.add( &sum );
+  total.add( &sum );
+  for( unsigned int rr = 0; rr < size; rr++ )
+    CHECK_EQUAL( 2 * sum.get_count( rr ), total.get_count( rr ) );
+}
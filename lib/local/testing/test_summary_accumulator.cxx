@@ -0,0 +1,119 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   test_summary_accumulator.cxx
+  Language: C++
+
+=========================================================================*/
+//
+// .SECTION Description
+// Unit tests for the summary_accumulator class
+//
+
+#include "UnitTest++.h"
+
+#include "summary.h"
+#include "summary_accumulator.h"
+#include "utilities.h"
+
+#include <cmath>
+#include <json/value.h>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
+
+TEST( test_summary_accumulator )
+{
+  // create a list of summaries with random counts
+  const unsigned int size = sampsim::utilities::rr.size();
+  vector< sampsim::summary > summary_list( 50 );
+  for( auto it = summary_list.begin(); it != summary_list.end(); ++it )
+  {
+    Json::Value json( Json::objectValue );
+    for( unsigned int rr = 0; rr < size; rr++ )
+    {
+      json["rr"].append( sampsim::utilities::rr[rr] );
+      Json::Value count( Json::arrayValue ), weighted_count( Json::arrayValue );
+      for( unsigned int i = 0; i < 16; i++ )
+      {
+        unsigned int value = sampsim::utilities::random( 1, 100 );
+        count.append( value );
+        weighted_count.append( value * 2.5 * sampsim::utilities::random() );
+      }
+      json["count"].append( count );
+      json["weighted_count"].append( weighted_count );
+    }
+    CHECK( it->from_json( json ) );
+  }
+
+  cout << "Testing that summaries are written one line per rr and group..." << endl;
+  sampsim::summary_accumulator accumulator( true );
+  for( auto it = summary_list.cbegin(); it != summary_list.cend(); ++it ) accumulator.add( &( *it ) );
+  CHECK_EQUAL( summary_list.size(), accumulator.get_number_of_summaries() );
+
+  stringstream stream;
+  accumulator.write( stream );
+  vector< vector< double > > line_list;
+  string line;
+  getline( stream, line ); // skip the header
+  while( getline( stream, line ) )
+  {
+    vector< string > column_list = sampsim::utilities::explode( line, "," );
+    CHECK_EQUAL( 15, column_list.size() );
+    vector< double > value_list;
+    for( unsigned int c = 2; c < column_list.size(); c++ ) value_list.push_back( atof( column_list[c].c_str() ) );
+    line_list.push_back( value_list );
+  }
+  CHECK_EQUAL( 9 * size, line_list.size() );
+
+  cout << "Testing accumulated statistics against two-pass statistics..." << endl;
+  sampsim::summary total;
+  for( auto it = summary_list.cbegin(); it != summary_list.cend(); ++it ) total.add( &( *it ) );
+  const double n = summary_list.size();
+  for( unsigned int rr = 0; rr < size; rr++ )
+  {
+    // the first line of every rr is the total of all ages and sexes
+    const vector< double > &value = line_list[rr * 9];
+    double rr_mean = 0, rr_squared_sum = 0, squared_sum = 0, numerator = 0, denominator = 0;
+    double mean = total.get_count_fraction( rr );
+    for( auto it = summary_list.cbegin(); it != summary_list.cend(); ++it )
+      rr_mean += it->get_relative_risk( rr ) / n;
+    for( auto it = summary_list.cbegin(); it != summary_list.cend(); ++it )
+    {
+      double diff = it->get_relative_risk( rr ) - rr_mean;
+      rr_squared_sum += diff * diff;
+      diff = it->get_count_fraction( rr ) - mean;
+      squared_sum += diff * diff;
+      numerator += it->get_pooled_risk_numerator( rr );
+      denominator += it->get_pooled_risk_denominator( rr );
+    }
+
+    CHECK_CLOSE( sampsim::utilities::rr[rr], value[0], 1e-9 );
+    CHECK_EQUAL( total.get_count( rr, sampsim::ANY_AGE, sampsim::ANY_SEX, sampsim::DISEASED ), value[1] );
+    CHECK_EQUAL( total.get_count( rr ), value[2] );
+    CHECK_CLOSE( rr_mean, value[3], 1e-4 * rr_mean );
+    CHECK_CLOSE( sqrt( rr_squared_sum / n ), value[4], 1e-4 * value[4] );
+    CHECK_CLOSE( numerator / denominator, value[5], 1e-4 * value[5] );
+    CHECK_CLOSE( mean, value[6], 1e-4 * mean );
+    CHECK_CLOSE( sqrt( squared_sum / ( n - 1 ) ), value[7], 1e-4 * value[7] );
+  }
+
+  cout << "Testing that summary::write() matches the accumulator..." << endl;
+  vector< sampsim::summary* > pointer_list;
+  for( auto it = summary_list.begin(); it != summary_list.end(); ++it ) pointer_list.push_back( &( *it ) );
+  stringstream summary_stream;
+  sampsim::summary::write( pointer_list, true, summary_stream );
+  CHECK_EQUAL( stream.str(), summary_stream.str() );
+
+  cout << "Testing resetting the accumulator..." << endl;
+  accumulator.reset( false );
+  CHECK_EQUAL( 0, accumulator.get_number_of_summaries() );
+  stringstream unweighted_stream;
+  accumulator.add( &summary_list[0] );
+  accumulator.write( unweighted_stream );
+  getline( unweighted_stream, line );
+  CHECK_EQUAL( "type,group,individual_rr,diseased,total,rr,rr_stdev,rr_pooled,prevalence,stdev", line );
+}
@@ -0,0 +1,96 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   test_town_selection.cxx
+  Language: C++
+
+=========================================================================*/
+//
+// .SECTION Description
+// Unit tests for the town_selection class
+//
+
+#include "UnitTest++.h"
+
+#include "town_selection.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
+
+TEST( test_town_selection )
+{
+  typedef sampsim::town_selection selection;
+  sampsim::utilities::random_engine.seed( 1234 );
+
+  // towns of very different sizes, including an empty one
+  vector< unsigned int > size_list = { 100, 0, 400, 50, 1000, 250, 200 };
+  unsigned int total = 0;
+  for( auto it = size_list.cbegin(); it != size_list.cend(); ++it ) total += *it;
+
+  sampsim::town_selection towns;
+  CHECK_THROW( towns.select( 1 ), std::runtime_error );
+  towns.set_size_list( size_list );
+  CHECK_EQUAL( size_list.size(), towns.get_number_of_towns() );
+  CHECK_EQUAL( total, towns.get_total_size() );
+
+  cout << "Testing method names..." << endl;
+  CHECK_EQUAL( selection::SYSTEMATIC_PPS, towns.get_method() );
+  CHECK_EQUAL( selection::STRATIFIED_PPS, selection::get_method_type( "stratified" ) );
+  CHECK_EQUAL( "pps", selection::get_method_type_name( selection::PPS_WITH_REPLACEMENT ) );
+  CHECK_EQUAL( selection::UNKNOWN_METHOD_TYPE, selection::get_method_type( "cluster" ) );
+  CHECK_THROW( towns.set_method( selection::UNKNOWN_METHOD_TYPE ), std::runtime_error );
+
+  cout << "Testing the town lookup..." << endl;
+  CHECK_EQUAL( 0, towns.get_town_index( 1 ) );
+  CHECK_EQUAL( 0, towns.get_town_index( 100 ) );
+  CHECK_EQUAL( 2, towns.get_town_index( 101 ) );
+  CHECK_EQUAL( 3, towns.get_town_index( 501 ) );
+  CHECK_EQUAL( 6, towns.get_town_index( total ) );
+  CHECK_THROW( towns.get_town_index( 0 ), std::runtime_error );
+  CHECK_THROW( towns.get_town_index( total + 1 ), std::runtime_error );
+  CHECK_CLOSE( 400.0 / total, towns.get_selection_fraction( 2 ), 1e-12 );
+
+  const unsigned int draws = 20000;
+  vector< selection::method_type > pps_list =
+    { selection::SYSTEMATIC_PPS, selection::PPS_WITH_REPLACEMENT, selection::STRATIFIED_PPS };
+  for( auto method_it = pps_list.cbegin(); method_it != pps_list.cend(); ++method_it )
+  {
+    cout << "Testing " << selection::get_method_type_name( *method_it ) << " selection..." << endl;
+    towns.set_method( *method_it );
+
+    // every town should be selected in proportion to its size
+    vector< double > count_list( size_list.size(), 0 );
+    for( unsigned int draw = 0; draw < draws; draw++ )
+    {
+      vector< unsigned int > index_list = towns.select( 4 );
+      CHECK_EQUAL( 4, index_list.size() );
+      for( auto it = index_list.cbegin(); it != index_list.cend(); ++it ) count_list[*it]++;
+    }
+    for( unsigned int index = 0; index < size_list.size(); index++ )
+      CHECK_CLOSE( towns.get_selection_fraction( index ), count_list[index] / ( 4 * draws ), 0.01 );
+  }
+  CHECK_THROW( towns.select( total + 1 ), std::runtime_error );
+
+  cout << "Testing simple random selection..." << endl;
+  towns.set_method( selection::SIMPLE_RANDOM );
+  CHECK_CLOSE( 1.0 / size_list.size(), towns.get_selection_fraction( 4 ), 1e-12 );
+  vector< double > count_list( size_list.size(), 0 );
+  for( unsigned int draw = 0; draw < draws; draw++ )
+  {
+    vector< unsigned int > index_list = towns.select( 3 );
+    CHECK( std::is_sorted( index_list.cbegin(), index_list.cend() ) );
+    CHECK_EQUAL( 3, set< unsigned int >( index_list.cbegin(), index_list.cend() ).size() );
+    for( auto it = index_list.cbegin(); it != index_list.cend(); ++it ) count_list[*it]++;
+  }
+  for( unsigned int index = 0; index < size_list.size(); index++ )
+    CHECK_CLOSE( 3.0 / size_list.size(), count_list[index] / draws, 0.02 );
+  CHECK_EQUAL( size_list.size(), towns.select( size_list.size() ).size() );
+  CHECK_THROW( towns.select( size_list.size() + 1 ), std::runtime_error );
+}
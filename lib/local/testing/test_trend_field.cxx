@@ -0,0 +1,87 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   test_trend_field.cxx
+  Language: C++
+
+=========================================================================*/
+//
+// .SECTION Description
+// Unit tests for the trend_field class
+//
+
+#include "UnitTest++.h"
+
+#include "coordinate.h"
+#include "trend.h"
+#include "trend_field.h"
+#include "utilities.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+int main( const int argc, const char** argv ) { return UnitTest::RunAllTests(); }
+
+TEST( test_trend_field )
+{
+  const unsigned int size = sampsim::trend_field::NUMBER_OF_FIELDS;
+  sampsim::trend trends[size] = {
+    sampsim::trend( 1, 2, 3, 4, 5, 6 ),
+    sampsim::trend( 0.5, -0.1, 0.2, 0.01, -0.02, 0.03 ),
+    sampsim::trend( -1, 0, 0, 0.5, 0.5, 0 ),
+    sampsim::trend( 2 ),
+    sampsim::trend( 0, 1, -1, 0, 0, 1 ),
+    sampsim::trend( 3, 0.3, 0.2, -0.1, 0.1, -0.2 )
+  };
+  sampsim::trend *trend_list[size];
+  for( unsigned int f = 0; f < size; f++ ) trend_list[f] = &trends[f];
+
+  sampsim::trend_field field;
+  double values[size];
+  CHECK( !field.is_set() );
+  CHECK_THROW( field.evaluate( sampsim::coordinate(), values ), std::runtime_error );
+
+  cout << "Testing that fields match trend values..." << endl;
+  field.set_trends( trend_list );
+  CHECK( field.is_set() );
+  vector< sampsim::coordinate > position_list;
+  for( int i = 0; i < 1000; ++i )
+    position_list.push_back( sampsim::coordinate( 10 * sampsim::utilities::random(),
+                                                  10 * sampsim::utilities::random() ) );
+  vector< double > value_list( size * position_list.size() );
+  field.evaluate( position_list.size(), position_list.data(), value_list.data() );
+  for( unsigned int i = 0; i < position_list.size(); i++ )
+  {
+    field.evaluate( position_list[i], values );
+    for( unsigned int f = 0; f < size; f++ )
+    {
+      CHECK_EQUAL( trends[f].get_value( position_list[i] ), value_list[i * size + f] );
+      CHECK_EQUAL( value_list[i * size + f], values[f] );
+    }
+  }
+
+  cout << "Testing lattice interpolation..." << endl;
+  field.build_lattice( sampsim::coordinate( 0, 0 ), sampsim::coordinate( 10, 10 ), 0.05 );
+  CHECK( field.has_lattice() );
+  field.evaluate( position_list.size(), position_list.data(), value_list.data() );
+  for( unsigned int i = 0; i < position_list.size(); i++ )
+  {
+    // trends without squared terms are bilinear so the lattice is exact (apart from rounding)
+    CHECK_CLOSE( trends[4].get_value( position_list[i] ), value_list[i * size + 4], 1e-9 );
+    for( unsigned int f = 0; f < size; f++ )
+      CHECK_CLOSE( trends[f].get_value( position_list[i] ), value_list[i * size + f], 0.01 );
+  }
+
+  // positions outside the lattice use the value at its edge
+  field.evaluate( sampsim::coordinate( 20, -5 ), values );
+  for( unsigned int f = 0; f < size; f++ )
+    CHECK_CLOSE( trends[f].get_value( sampsim::coordinate( 10, 0 ) ), values[f], 1e-9 );
+
+  field.clear_lattice();
+  CHECK( !field.has_lattice() );
+  field.evaluate( position_list[0], values );
+  CHECK_EQUAL( trends[0].get_value( position_list[0] ), values[0] );
+}
@@ -56,4 +56,96 @@ TEST( test_utilities )
   cout << "Testing the trim function..." << endl;
   test = " \n\t test string \t\n ";
   CHECK_EQUAL( "test string", sampsim::utilities::trim( test ) );
+
+  cout << "Testing the fill_random function..." << endl;
+  sampsim::utilities::random_engine.seed( 1234 );
+  vector< double > single_list;
+  for( int i = 0; i < 100; i++ ) single_list.push_back( sampsim::utilities::random() );
+  sampsim::utilities::random_engine.seed( 1234 );
+  vector< double > batch_list( 100 );
+  sampsim::utilities::fill_random( batch_list.data(), batch_list.size() );
+  CHECK( single_list == batch_list );
+
+  stringstream temp_filename;
+  temp_filename << "/tmp/sampsim" << sampsim::utilities::random( 1000000, 9999999 );
+
+  // build enough data to be divided into many compression blocks
+  stringstream data_stream;
+  for( unsigned int i = 0; i < 200000; i++ ) data_stream << i << "," << ( i * 7919 % 1000 ) << "\n";
+  sampsim::file_list_type files;
+  files["first.csv"] = data_stream.str();
+  files["second.csv"] = "a short file";
+
+  cout << "Testing the write_gzip function using multiple threads..." << endl;
+  sampsim::utilities::compression_threads = 4;
+  sampsim::utilities::write_gzip( temp_filename.str(), files );
+  string tar_filename = temp_filename.str() + ".tar.gz";
+  CHECK_EQUAL( "ok", sampsim::utilities::exec( "gzip -t " + tar_filename + " && echo ok" ) );
+
+  cout << "Testing the read_gzip function..." << endl;
+  sampsim::file_list_type read_files = sampsim::utilities::read_gzip( tar_filename );
+  CHECK_EQUAL( 2, read_files.size() );
+  CHECK( files["first.csv"] == read_files["first.csv"] );
+  CHECK_EQUAL( files["second.csv"], read_files["second.csv"] );
+
+  cout << "Testing the for_each_entry function..." << endl;
+  vector< string > name_list;
+  unsigned int line_count = 0;
+  sampsim::utilities::for_each_entry(
+    tar_filename,
+    [&]( const string &name, istream &stream )
+    {
+      name_list.push_back( name );
+      string line;
+      while( getline( stream, line ) ) line_count++;
+      return true;
+    } );
+  CHECK_EQUAL( 2, name_list.size() );
+  CHECK_EQUAL( "first.csv", name_list[0] );
+  CHECK_EQUAL( "second.csv", name_list[1] );
+  CHECK_EQUAL( 200001, line_count );
+
+  // entries which aren't read are skipped and returning false stops reading
+  name_list.clear();
+  sampsim::utilities::for_each_entry(
+    tar_filename,
+    [&]( const string &name, istream &stream )
+    {
+      name_list.push_back( name );
+      return false;
+    } );
+  CHECK_EQUAL( 1, name_list.size() );
+  CHECK_THROW( sampsim::utilities::for_each_entry(
+    temp_filename.str() + ".missing", []( const string &name, istream &stream ) { return true; } ),
+    std::runtime_error );
+
+  cout << "Testing the write_gzip function without compression..." << endl;
+  sampsim::utilities::compression_level = 0;
+  sampsim::utilities::write_gzip( temp_filename.str(), "replaced", true );
+  read_files = sampsim::utilities::read_gzip( tar_filename );
+  CHECK_EQUAL( 3, read_files.size() );
+  CHECK( files["first.csv"] == read_files["first.csv"] );
+  CHECK_EQUAL( "replaced", read_files[temp_filename.str()] );
+  sampsim::utilities::exec( "rm " + tar_filename );
+
+  cout << "Testing the fixed_list class..." << endl;
+  sampsim::fixed_list< int, 3 > list{ 4, 5 };
+  CHECK_EQUAL( 2, list.size() );
+  CHECK_EQUAL( 3, list.capacity() );
+  list.push_back( 6 );
+  CHECK_EQUAL( 15, list[0] + list[1] + list[2] );
+  CHECK_THROW( list.push_back( 7 ), std::runtime_error );
+  list.clear();
+  CHECK_EQUAL( 0, list.size() );
+
+  cout << "Testing the set_rr function..." << endl;
+  vector< double > rr_list( sampsim::utilities::rr.begin(), sampsim::utilities::rr.end() );
+  CHECK_THROW( sampsim::utilities::set_rr( vector< double >() ), std::runtime_error );
+  CHECK_THROW(
+    sampsim::utilities::set_rr( vector< double >( SAMPSIM_MAXIMUM_RR + 1, 1.0 ) ), std::runtime_error );
+  sampsim::utilities::set_rr( { 1.0, 5.0 } );
+  CHECK_EQUAL( 2, sampsim::utilities::rr.size() );
+  CHECK_EQUAL( 5.0, sampsim::utilities::rr[1] );
+  sampsim::utilities::set_rr( rr_list );
+  CHECK_EQUAL( rr_list.size(), sampsim::utilities::rr.size() );
 }
@@ -9,6 +9,7 @@
 #include "tile.h"
 
 #include "building.h"
+#include "csv_writer.h"
 #include "household.h"
 #include "individual.h"
 #include "population.h"
@@ -19,6 +20,7 @@
 #include <algorithm>
 #include <json/value.h>
 #include <stdexcept>
+#include <vector>
 
 namespace sampsim
 {
@@ -55,53 +57,74 @@ namespace sampsim
     if( utilities::verbose )
       utilities::output( "creating tile at %d, %d", this->index.first , this->index.second );
 
-    // need to keep creating buildings until the population density is met
+    std::vector< coordinate > position_list;
+    std::vector< std::vector< sex_type >::size_type > size_list;
+    std::vector< sex_type > sex_list;
+    this->plan_buildings( position_list, size_list, sex_list );
+
+    // now create all of the buildings at once
+    this->building_list.reserve( this->building_list.size() + position_list.size() );
+    const sex_type *sexes = sex_list.data();
+    for( std::vector< coordinate >::size_type c = 0; c < position_list.size(); c++ )
+    {
+      building *b = new building( this );
+      b->create( position_list[c], size_list[c], sexes );
+      sexes += size_list[c];
+      this->building_list.push_back( b );
+      this->number_of_individuals += b->get_number_of_individuals();
+    }
+
+    if( utilities::verbose )
+      utilities::output( "finished creating tile: %d buildings created",
+                         this->building_list.size() );
+
+    this->get_population()->expire_summary();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  unsigned int tile::measure()
+  {
+    std::vector< coordinate > position_list;
+    std::vector< std::vector< sex_type >::size_type > size_list;
+    std::vector< sex_type > sex_list;
+    return this->plan_buildings( position_list, size_list, sex_list );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  unsigned int tile::plan_buildings(
+    std::vector< coordinate > &position_list,
+    std::vector< std::vector< sex_type >::size_type > &size_list,
+    std::vector< sex_type > &sex_list )
+  {
+    // need to keep adding buildings until the population density is met
     // to avoid over-populating a town we want half of the tile to stop adding buildings just after
     // they meet the density and the other half to stop adding buildings just before they meet the
     // density
-    unsigned int count = 0;
     double current_density = 0;
     double area = this->get_area();
     bool stop_after = 0 != ( this->index.first + this->index.second ) % 2;
+    unsigned int new_number_of_individuals = this->number_of_individuals;
+    std::vector< sex_type > member_list;
 
+    // every building's position and members are drawn first, in the same order that building::create()
+    // draws them, so that the number of buildings is known before anything is allocated
     while( current_density < this->population_density )
     {
-      // create the building
-      building *b = new building( this );
-      b->create();
-      unsigned int new_number_of_individuals = this->number_of_individuals + b->get_number_of_individuals();
-      current_density = static_cast< double >( new_number_of_individuals ) / area;
+      coordinate position = building::draw_position( this );
+      household::draw_members( this->get_town(), member_list );
+      current_density = static_cast< double >( new_number_of_individuals + member_list.size() ) / area;
 
-      // store it in the building list, but not if we are not stopping after the density is met
-      // and this is the last building to be added
-      if( !stop_after && current_density >= this->population_density )
+      // the last building is not added if we are not stopping after the density is met
+      if( stop_after || current_density < this->population_density )
       {
-        // remove all households and individuals from the population's reference maps
-        for( auto h_it = b->get_household_list_cbegin(); h_it != b->get_household_list_cend(); ++h_it )
-        {
-          household *h = *h_it;
-          this->get_population()->remove_household( h->get_index() );
-          for( auto i_it = h->get_individual_list_cbegin(); i_it != h->get_individual_list_cend(); ++i_it )
-          {
-            individual *i = *i_it;
-            this->get_population()->remove_individual( i->get_index() );
-          }
-        }
-
-        utilities::safe_delete( b );
-      }
-      else
-      {
-        this->building_list.push_back( b );
-        this->number_of_individuals += b->get_number_of_individuals();
+        position_list.push_back( position );
+        size_list.push_back( member_list.size() );
+        sex_list.insert( sex_list.end(), member_list.begin(), member_list.end() );
+        new_number_of_individuals += member_list.size();
       }
     }
 
-    if( utilities::verbose )
-      utilities::output( "finished creating tile: %d buildings created",
-                         this->building_list.size() );
-
-    this->get_population()->expire_summary();
+    return new_number_of_individuals - this->number_of_individuals;
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -115,7 +138,24 @@ namespace sampsim
     this->disease_risk_distribution.set_normal( this->mean_disease, this->sd_disease );
     this->exposure_risk_distribution.set_normal( this->mean_exposure, this->sd_exposure );
 
-    for( auto it = this->building_list.begin(); it != this->building_list.end(); ++it ) (*it)->define();
+    // evaluate the town's trends at every household's position and draw the random part of every
+    // household's income and risk factors, each in one batch
+    std::vector< coordinate > position_list;
+    for( auto it = this->building_list.cbegin(); it != this->building_list.cend(); ++it )
+      position_list.insert( position_list.end(), (*it)->household_list.size(), (*it)->get_position() );
+    std::vector< double > trend_list( trend_field::NUMBER_OF_FIELDS * position_list.size() );
+    this->get_town()->get_trend_field()->evaluate(
+      position_list.size(), position_list.data(), trend_list.data() );
+    std::vector< double > normal_list( 3 * position_list.size() );
+    distribution::generate_independent_normal_values( normal_list.size(), normal_list.data() );
+
+    const double *normal_values = normal_list.data(), *trend_values = trend_list.data();
+    for( auto it = this->building_list.begin(); it != this->building_list.end(); ++it )
+    {
+      (*it)->define( normal_values, trend_values );
+      normal_values += 3 * (*it)->household_list.size();
+      trend_values += trend_field::NUMBER_OF_FIELDS * (*it)->household_list.size();
+    }
 
     if( utilities::verbose ) utilities::output( "finished defining tile" );
   }
@@ -179,12 +219,21 @@ namespace sampsim
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void tile::to_csv( std::ostream &household_stream, std::ostream &individual_stream ) const
+  {
+    csv_writer household_writer, individual_writer;
+    this->to_csv( household_writer, individual_writer );
+    household_stream << household_writer.str();
+    individual_stream << individual_writer.str();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void tile::to_csv( csv_writer &household_writer, csv_writer &individual_writer ) const
   {
     bool sample_mode = this->get_population()->get_sample_mode();
     for( auto it = this->building_list.begin(); it != this->building_list.end(); ++it )
     {
       building *b = *it;
-      if( !sample_mode || b->is_selected() ) b->to_csv( household_stream, individual_stream );
+      if( !sample_mode || b->is_selected() ) b->to_csv( household_writer, individual_writer );
     }
   }
 
@@ -210,18 +259,32 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void tile::assert_summary()
   {
+    // tiles don't keep their summary so it is rebuilt from their households' every time it is requested
     this->get_population()->assert_summary();
+    this->rebuild_summary();
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void tile::rebuild_summary()
   {
-    this->sum.reset();
+    this->add_to_summary( this->reset_summary(), false );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void tile::add_to_summary( summary *sum, const bool rebuild )
+  {
+    summary tile_sum, building_sum;
     for( auto it = this->building_list.begin(); it != this->building_list.end(); ++it )
     {
-      (*it)->rebuild_summary();
-      this->sum.add( (*it) );
+      building_sum.reset();
+      for( auto hit = (*it)->get_household_list_begin(); hit != (*it)->get_household_list_end(); ++hit )
+      {
+        if( rebuild ) (*hit)->rebuild_summary();
+        building_sum.add( *hit );
+      }
+      tile_sum.add( &building_sum );
     }
+    sum->add( &tile_sum );
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
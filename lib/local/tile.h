@@ -24,6 +24,7 @@ namespace Json { class Value; }
 namespace sampsim
 {
   class building;
+  class csv_writer;
   class population;
   class town;
 
@@ -78,6 +79,21 @@ namespace sampsim
     void unselect();
     void select_all();
 
+    /**
+     * Output object to two CSV writers (households and individuals)
+     */
+    void to_csv( csv_writer&, csv_writer& ) const;
+
+    /**
+     * Adds the tile's households to a summary
+     * 
+     * Households are added building by building and the tile's total is added to the summary last so that
+     * counts are summed in the same order as the population's tree.  If rebuild is true then each
+     * household's summary is rebuilt first (used by towns, the only level above households which keeps
+     * its summary).
+     */
+    void add_to_summary( summary *sum, const bool rebuild );
+
     /**
      * Iterator access to child buildings
      * 
@@ -234,6 +250,24 @@ namespace sampsim
     void create();
     void define();
 
+    /**
+     * Returns the number of individuals create() would add to the tile, without creating them
+     * 
+     * The same random numbers are drawn as by create().
+     */
+    unsigned int measure();
+
+    /**
+     * Draws the position and members of every building create() adds to the tile
+     * 
+     * Buildings are added until the tile's population density is met, returning the number of
+     * individuals in all buildings.
+     */
+    unsigned int plan_buildings(
+      std::vector< coordinate > &position_list,
+      std::vector< std::vector< sex_type >::size_type > &size_list,
+      std::vector< sex_type > &sex_list );
+
   private:
     /**
      * Sets the tile's 2D index within the town
@@ -9,6 +9,7 @@
 #include "town.h"
 
 #include "building.h"
+#include "csv_writer.h"
 #include "household.h"
 #include "individual.h"
 #include "population.h"
@@ -19,6 +20,7 @@
 
 #include <ctime>
 #include <fstream>
+#include <functional>
 #include <json/reader.h>
 #include <json/value.h>
 #include <json/writer.h>
@@ -46,8 +48,7 @@ namespace sampsim
     this->population_density = new trend;
     this->number_of_individuals = 0;
     this->number_of_selected_individuals = 0;
-    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
-      this->number_of_selected_diseased_individuals.push_back( 0 );
+    this->number_of_selected_diseased_individuals.fill( 0 );
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -82,29 +83,7 @@ namespace sampsim
 
     population *pop = this->get_population();
 
-    // define the river's parameters based on whether it has a river or not
-    if( this->has_river )
-    {
-      coordinate intercept = coordinate( utilities::random() * this->get_x_width(),
-                                         utilities::random() * this->get_y_width() );
-      intercept.set_centroid( this->get_centroid() );
-      double angle = safe_subtract( utilities::random(), 0.5 ) * M_PI; // from -pi/2 to pi/2
-      double sin_angle = sin( angle );
-      double cos_angle = cos( angle );
-      double width = this->get_population()->get_river_width();
-
-      this->river_banks[0].angle = angle;
-      this->river_banks[0].intercept = coordinate( intercept.x + sin_angle * width / 2,
-                                                   safe_subtract( intercept.y, cos_angle * width / 2 ) );
-      this->river_banks[1].angle = angle;
-      this->river_banks[1].intercept = coordinate( safe_subtract( intercept.x, sin_angle * width / 2 ),
-                                                   intercept.y + cos_angle * width / 2 );
-    }
-    else
-    {
-      this->river_banks[0] = line();
-      this->river_banks[1] = line();
-    }
+    this->create_river();
 
     // delete all tiles
     for( auto it = this->tile_list.begin(); it != this->tile_list.end(); ++it )
@@ -136,6 +115,64 @@ namespace sampsim
     this->get_population()->expire_summary();
   }
 
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  unsigned int town::measure()
+  {
+    std::pair< unsigned int, unsigned int > index;
+
+    this->create_river();
+
+    // delete all tiles
+    for( auto it = this->tile_list.begin(); it != this->tile_list.end(); ++it )
+      utilities::safe_delete( it->second );
+    this->tile_list.clear();
+
+    // create the needed distributions
+    this->population_distribution.set_poisson( this->mean_household_population - 1 );
+
+    // measure each tile in the same order as they are created
+    for( unsigned int y = 0; y < this->number_of_tiles_y; y++ )
+    {
+      for( unsigned int x = 0; x < this->number_of_tiles_x; x++ )
+      {
+        index = std::pair< unsigned int, unsigned int >( x, y );
+        tile t( this, index );
+        t.set_population_density( this->population_density->get_value( t.get_centroid() ) );
+        this->number_of_individuals += t.measure();
+      }
+    }
+
+    return this->number_of_individuals;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void town::create_river()
+  {
+    // define the river's parameters based on whether it has a river or not
+    if( this->has_river )
+    {
+      coordinate intercept = coordinate( utilities::random() * this->get_x_width(),
+                                         utilities::random() * this->get_y_width() );
+      intercept.set_centroid( this->get_centroid() );
+      double angle = safe_subtract( utilities::random(), 0.5 ) * M_PI; // from -pi/2 to pi/2
+      double sin_angle = sin( angle );
+      double cos_angle = cos( angle );
+      double width = this->get_population()->get_river_width();
+
+      this->river_banks[0].angle = angle;
+      this->river_banks[0].intercept = coordinate( intercept.x + sin_angle * width / 2,
+                                                   safe_subtract( intercept.y, cos_angle * width / 2 ) );
+      this->river_banks[1].angle = angle;
+      this->river_banks[1].intercept = coordinate( safe_subtract( intercept.x, sin_angle * width / 2 ),
+                                                   intercept.y + cos_angle * width / 2 );
+    }
+    else
+    {
+      this->river_banks[0] = line();
+      this->river_banks[1] = line();
+    }
+  }
+
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void town::define()
   {
@@ -147,125 +184,186 @@ namespace sampsim
 
     population *pop = this->get_population();
 
+    // bake the trends (in the order they were first evaluated when each was evaluated separately)
+    trend* trend_list[trend_field::NUMBER_OF_FIELDS] =
+      { this->mean_income, this->sd_income, this->mean_disease,
+        this->sd_disease, this->mean_exposure, this->sd_exposure };
+    this->field.set_trends( trend_list );
+    if( 0 < pop->get_trend_lattice_resolution() )
+    {
+      double width = pop->get_tile_width();
+      this->field.build_lattice(
+        coordinate( 0, 0 ),
+        coordinate( this->number_of_tiles_x * width, this->number_of_tiles_y * width ),
+        width / pop->get_trend_lattice_resolution() );
+    }
+
+    // the pocket kernel is chosen once for all buildings
+    this->pocket_factor_field.set_pockets(
+      this->disease_pocket_list,
+      pop->get_pocket_kernel_type(),
+      pop->get_pocket_scaling(),
+      pop->get_pocket_cutoff() );
+
     // define all tiles
     for( auto it = this->tile_list.begin(); it != this->tile_list.end(); ++it )
     {
       // set the income and disease risk then define the tile
       tile *t = it->second;
-      coordinate centroid = t->get_centroid();
-      t->set_mean_income( this->mean_income->get_value( centroid ) );
-      t->set_sd_income( this->sd_income->get_value( centroid ) );
-      t->set_mean_disease( this->mean_disease->get_value( centroid ) );
-      t->set_sd_disease( this->sd_disease->get_value( centroid ) );
-      t->set_mean_exposure( this->mean_exposure->get_value( centroid ) );
-      t->set_sd_exposure( this->sd_exposure->get_value( centroid ) );
+      double value[trend_field::NUMBER_OF_FIELDS];
+      this->field.evaluate( t->get_centroid(), value );
+      t->set_mean_income( value[trend_field::MEAN_INCOME] );
+      t->set_sd_income( value[trend_field::SD_INCOME] );
+      t->set_mean_disease( value[trend_field::MEAN_DISEASE] );
+      t->set_sd_disease( value[trend_field::SD_DISEASE] );
+      t->set_mean_exposure( value[trend_field::MEAN_EXPOSURE] );
+      t->set_sd_exposure( value[trend_field::SD_EXPOSURE] );
       t->define();
     }
 
     // now that the town has been created and all tiles defined we can determine disease status
     // we are going to do this in a standard generalized-linear-model way, by constructing a linear
     // function of the various contributing factors
-
-    // create a matrix of all individuals (rows) and their various disease predictor factors
+    //
+    // All factors other than an individual's age and sex are shared by everyone in a household, so
+    // instead of building a matrix of every individual's factors the town's households are visited three
+    // times: to draw exposures and sum the factors, to sum the squared deviations from their means and
+    // finally to determine disease status.  The sums are made one individual at a time in the same order
+    // as a column-by-column pass over the full matrix would, so results don't depend on how the town is
+    // traversed.
     const unsigned int number_of_disease_weights = pop->get_number_of_disease_weights();
-    double value[number_of_disease_weights], total[number_of_disease_weights];
-    for( unsigned int c = 0; c < number_of_disease_weights; c++ ) total[c] = 0;
-
-    std::vector< double > matrix[number_of_disease_weights];
+    const unsigned int number_of_rr = utilities::rr.size();
+    double value[number_of_disease_weights], total[number_of_disease_weights],
+           mean[number_of_disease_weights], sd[number_of_disease_weights], weight[number_of_disease_weights];
     for( unsigned int c = 0; c < number_of_disease_weights; c++ )
-      matrix[c].resize( this->number_of_individuals );
-    individual_list_type individual_list;
-    individual_list.resize( this->number_of_individuals );
-
-    unsigned int individual_index = 0;
+    {
+      total[c] = 0;
+      sd[c] = 0;
+      weight[c] = pop->get_disease_weight_by_index( c );
+    }
 
-    for( auto tile_it = this->tile_list.begin();
-         tile_it != this->tile_list.end();
-         ++tile_it )
+    // calls the callback for every household along with its building and individuals
+    auto for_each_household = [this]( const std::function< void( building*, household* ) > &callback )
+    {
+      for( auto tile_it = this->tile_list.begin(); tile_it != this->tile_list.end(); ++tile_it )
+        for( auto building_it = tile_it->second->get_building_list_cbegin();
+             building_it != tile_it->second->get_building_list_cend();
+             ++building_it )
+          for( auto household_it = ( *building_it )->get_household_list_cbegin();
+               household_it != ( *building_it )->get_household_list_cend();
+               ++household_it )
+            callback( *building_it, *household_it );
+    };
+
+    // random numbers are drawn one household at a time, in the same order as they are used
+    std::vector< double > random_list;
+
+    // first pass: determine exposure and sum all disease predictor factors
+    for_each_household( [&]( building *b, household *h )
     {
-      for( auto building_it = tile_it->second->get_building_list_cbegin();
-           building_it != tile_it->second->get_building_list_cend();
-           ++building_it )
+      double exposure_risk = h->get_exposure_risk();
+      value[0] = h->get_number_of_individuals();
+      value[1] = h->get_income();
+      value[2] = h->get_disease_risk();
+      value[5] = b->get_pocket_factor();
+
+      random_list.resize( h->get_number_of_individuals() );
+      utilities::fill_random( random_list.data(), random_list.size() );
+      auto random_it = random_list.cbegin();
+      for( auto it = h->get_individual_list_cbegin(); it != h->get_individual_list_cend(); ++it, ++random_it )
       {
-        value[5] = ( *building_it )->get_pocket_factor();
-        for( auto household_it = ( *building_it )->get_household_list_cbegin();
-             household_it != ( *building_it )->get_household_list_cend();
-             ++household_it )
-        {
-          double exposure_risk = ( *household_it )->get_exposure_risk();
-          value[0] = ( *household_it )->get_number_of_individuals();
-          value[1] = ( *household_it )->get_income();
-          value[2] = ( *household_it )->get_disease_risk();
-
-          for( auto individual_it = ( *household_it )->get_individual_list_cbegin();
-               individual_it != ( *household_it )->get_individual_list_cend();
-               ++individual_it )
-          {
-            ( *individual_it )->set_exposure( utilities::random() < exposure_risk );
-            value[3] = ADULT == ( *individual_it )->get_age() ? 1 : 0;
-            value[4] = MALE == ( *individual_it )->get_sex() ? 1 : 0;
-
-            for( unsigned int c = 0; c < number_of_disease_weights; c++ )
-            {
-              total[c] += value[c];
-              matrix[c][individual_index] = value[c];
-            }
-
-            // keep a reference to the individual for writing to later
-            individual_list[individual_index] = ( *individual_it );
-
-            individual_index++;
-          }
-        }
+        ( *it )->set_exposure( *random_it < exposure_risk );
+        value[3] = ADULT == ( *it )->get_age() ? 1 : 0;
+        value[4] = MALE == ( *it )->get_sex() ? 1 : 0;
+        for( unsigned int c = 0; c < number_of_disease_weights; c++ ) total[c] += value[c];
       }
-    }
-
-    // subtract the mean of a column from each of its values and divide by the column's sd
-    double mean[number_of_disease_weights], sd[number_of_disease_weights];
+    } );
 
     for( unsigned int c = 0; c < number_of_disease_weights; c++ )
-    {
       mean[c] = total[c] / this->number_of_individuals;
-      sd[c] = 0;
-      for( unsigned int i = 0; i < this->number_of_individuals; i++ )
+
+    // second pass: determine each factor's standard deviation
+    for_each_household( [&]( building *b, household *h )
+    {
+      value[0] = h->get_number_of_individuals();
+      value[1] = h->get_income();
+      value[2] = h->get_disease_risk();
+      value[5] = b->get_pocket_factor();
+
+      for( auto it = h->get_individual_list_cbegin(); it != h->get_individual_list_cend(); ++it )
       {
-        double diff = safe_subtract( matrix[c][i], mean[c] );
-        sd[c] += diff*diff;
+        value[3] = ADULT == ( *it )->get_age() ? 1 : 0;
+        value[4] = MALE == ( *it )->get_sex() ? 1 : 0;
+        for( unsigned int c = 0; c < number_of_disease_weights; c++ )
+        {
+          double diff = safe_subtract( value[c], mean[c] );
+          sd[c] += diff*diff;
+        }
       }
+    } );
+
+    for( unsigned int c = 0; c < number_of_disease_weights; c++ )
       sd[c] = sqrt( sd[c] / ( this->number_of_individuals - 1 ) );
 
-      for( unsigned int i = 0; i < this->number_of_individuals; i++ )
-      {
-        matrix[c][i] = 0 == sd[c]
-                     ? 0.0 // avoid division by 0
-                     : ( 1 == c ? -1 : 1 ) * // income should have an inverse relationship to disease
-                       safe_subtract( matrix[c][i], mean[c] ) / sd[c]; // normalize values
-      }
-    }
+    // returns a factor's weighted value after subtracting its mean and dividing by its sd
+    auto get_term = [&]( const unsigned int c, const double x )
+    {
+      double normalized = 0 == sd[c]
+                        ? 0.0 // avoid division by 0
+                        : ( 1 == c ? -1 : 1 ) * // income should have an inverse relationship to disease
+                          safe_subtract( x, mean[c] ) / sd[c]; // normalize values
+      return normalized * weight[c];
+    };
+
+    // age and sex only have two possible values each
+    const double age_term[] = { get_term( 3, 0 ), get_term( 3, 1 ) };
+    const double sex_term[] = { get_term( 4, 0 ), get_term( 4, 1 ) };
 
     // Determine the target_prevalence factor
     // This is an ad-hoc transformation described in the disease status documentation
-    double base_probability, probability;
     double adjusted_prevalence_factor = ( sin( (M_PI/2)*(2*pop->get_target_prevalence() - 1) ) + 1 )/2;
     double target_prevalence_factor = log( 1/adjusted_prevalence_factor - 1 );
 
-    // factor in weights, compute disease probability then set disease status for all individuals
-    for( unsigned int i = 0; i < this->number_of_individuals; i++ )
+    // third pass: factor in weights, compute disease probability then set disease status for all individuals
+    std::vector< double > probability_list;
+    for_each_household( [&]( building *b, household *h )
     {
-      double eta = 0;
-      for( unsigned int c = 0; c < number_of_disease_weights; c++ )
-        eta += matrix[c][i] * pop->get_disease_weight_by_index( c );
+      // the terms are added in factor order, so the household's terms come first
+      double household_eta = get_term( 0, h->get_number_of_individuals() );
+      household_eta += get_term( 1, h->get_income() );
+      household_eta += get_term( 2, h->get_disease_risk() );
+      double pocket_term = get_term( 5, b->get_pocket_factor() );
+
+      unsigned int size = h->get_number_of_individuals();
+      probability_list.resize( size );
+      unsigned int index = 0;
+      for( auto it = h->get_individual_list_cbegin(); it != h->get_individual_list_cend(); ++it, ++index )
+      {
+        double eta = household_eta + age_term[ADULT == ( *it )->get_age() ? 1 : 0];
+        eta += sex_term[MALE == ( *it )->get_sex() ? 1 : 0];
+        eta += pocket_term;
+        probability_list[index] = eta - target_prevalence_factor;
+      }
+
+      // the logistic function is evaluated over the whole block of individuals at once
+      for( index = 0; index < size; index++ )
+        probability_list[index] = 1 / ( 1 + exp( -probability_list[index] ) );
 
-      eta -= target_prevalence_factor;
-      base_probability = 1 / ( 1 + exp( -eta ) );
-      for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+      random_list.resize( size * number_of_rr );
+      utilities::fill_random( random_list.data(), random_list.size() );
+      auto random_it = random_list.cbegin();
+      index = 0;
+      for( auto it = h->get_individual_list_cbegin(); it != h->get_individual_list_cend(); ++it, ++index )
       {
-        // probability is equal to the base probability times the relative risk (max of 0.9)
-        probability = base_probability * ( individual_list[i]->is_exposed() ? utilities::rr[rr] : 1.0 );
-        if( 0.9 < probability ) probability = 0.9;
-        individual_list[i]->set_disease( rr, utilities::random() < probability );
+        for( unsigned int rr = 0; rr < number_of_rr; rr++, ++random_it )
+        {
+          // probability is equal to the base probability times the relative risk (max of 0.9)
+          double probability = probability_list[index] * ( ( *it )->is_exposed() ? utilities::rr[rr] : 1.0 );
+          if( 0.9 < probability ) probability = 0.9;
+          ( *it )->set_disease( rr, *random_it < probability );
+        }
       }
-    }
+    } );
 
     stream.str( "" );
     stream << "finished defining town #" << ( this->index + 1 ) << ", "
@@ -350,10 +448,17 @@ namespace sampsim
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
-  void town::to_csv(
-    std::ostream &household_stream, std::ostream &individual_stream ) const
+  void town::to_csv( std::ostream &household_stream, std::ostream &individual_stream ) const
+  {
+    csv_writer household_writer, individual_writer;
+    this->to_csv( household_writer, individual_writer );
+    household_stream << household_writer.str();
+    individual_stream << individual_writer.str();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  std::string town::get_csv_header() const
   {
-    // put in the parameters
     std::stringstream stream;
     stream << "#" << std::endl
            << "# town parameters (index " << this->index << ")" << std::endl
@@ -376,15 +481,22 @@ namespace sampsim
            << "# sd_exposure trend: " << this->sd_exposure->to_string() << std::endl
            << "# population density trend: " << this->population_density->to_string() << std::endl
            << "#" << std::endl;
+    return stream.str();
+  }
 
-    household_stream << stream.str();
-    individual_stream << stream.str();
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void town::to_csv( csv_writer &household_writer, csv_writer &individual_writer ) const
+  {
+    // put in the parameters
+    std::string header = this->get_csv_header();
+    household_writer << header;
+    individual_writer << header;
 
     for( auto it = this->tile_list.cbegin(); it != this->tile_list.cend(); ++it )
-      it->second->to_csv( household_stream, individual_stream );
+      it->second->to_csv( household_writer, individual_writer );
 
-    household_stream << std::endl;
-    individual_stream << std::endl;
+    household_writer << '\n';
+    individual_writer << '\n';
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -478,12 +590,10 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void town::rebuild_summary()
   {
-    this->sum.reset();
+    // only households' summaries are kept below the town, tiles and buildings are summed as they are visited
+    summary *sum = this->reset_summary();
     for( auto it = this->tile_list.begin(); it != this->tile_list.end(); ++it )
-    {
-      it->second->rebuild_summary();
-      this->sum.add( it->second );
-    }
+      it->second->add_to_summary( sum, true );
   }
 
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
@@ -524,6 +634,9 @@ namespace sampsim
   {
     this->get_population()->expire_summary();
     this->selected = false;
+    this->number_of_selected_individuals = 0;
+    for( unsigned int rr = 0; rr < utilities::rr.size(); rr++ )
+      this->number_of_selected_diseased_individuals[rr] = 0;
 
     // unselect all buildings
     for( auto tile_it = this->tile_list.begin(); tile_it != this->tile_list.end(); ++tile_it )
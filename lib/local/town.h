@@ -10,9 +10,11 @@
 #define __sampsim_town_h
 
 #include "model_object.h"
+#include "pocket_field.h"
 
 #include "distribution.h"
 #include "line.h"
+#include "trend_field.h"
 #include "utilities.h"
 
 namespace Json{ class Value; }
@@ -24,6 +26,7 @@ namespace Json{ class Value; }
 
 namespace sampsim
 {
+  class csv_writer;
   class population;
   class tile;
   class trend;
@@ -81,6 +84,22 @@ namespace sampsim
     void unselect();
     void select_all();
 
+    /**
+     * Output object to two CSV writers (households and individuals)
+     * 
+     * Only reads from the town so different towns may be written by different threads once
+     * get_csv_header() has been called (see below).
+     */
+    void to_csv( csv_writer&, csv_writer& ) const;
+
+    /**
+     * Returns the header (town parameters) included at the start of the town's CSV data
+     * 
+     * Describing the town's trends caches their constants, which may generate random values, so this
+     * method must be called for each town in order before writing towns in parallel.
+     */
+    std::string get_csv_header() const;
+
     /**
      * Iterator access to child tiles
      * 
@@ -189,6 +208,20 @@ namespace sampsim
      */
     distribution* get_population_distribution() { return &( this->population_distribution ); }
 
+    /**
+     * Get the town's income, disease and exposure trends evaluated together
+     * 
+     * The field is built at the start of define() so it is only available once the town is defined.
+     */
+    const trend_field* get_trend_field() const { return &( this->field ); }
+
+    /**
+     * Get the combined influence of the town's disease pockets
+     * 
+     * Like the trend field this is set at the start of define().
+     */
+    const pocket_field* get_pocket_field() const { return &( this->pocket_factor_field ); }
+
     /**
      * Creates the provided number of disease pockets.
      * 
@@ -296,6 +329,19 @@ namespace sampsim
     void create();
     void define();
 
+    /**
+     * Returns the number of individuals create() would add to the town, without creating them
+     * 
+     * The same random numbers are drawn as by create() so the town can later be created identically
+     * by restoring the random generator's state.
+     */
+    unsigned int measure();
+
+    /**
+     * Determines the position of the town's river banks (if it has a river)
+     */
+    void create_river();
+
   private:
     /**
      * A reference to the populationn that the town belongs to (not reference counted)
@@ -337,6 +383,16 @@ namespace sampsim
      */
     distribution population_distribution;
 
+    /**
+     * The town's income, disease and exposure trends baked into a single field
+     */
+    trend_field field;
+
+    /**
+     * The town's disease pockets along with the population's kernel type, scaling and cutoff
+     */
+    pocket_field pocket_factor_field;
+
     /**
      * The trend defining the town's mean income
      * 
@@ -410,7 +466,7 @@ namespace sampsim
     /**
      * A cache of the number of selected individuals who are diseased
      */
-    std::vector<unsigned int> number_of_selected_diseased_individuals;
+    std::array< unsigned int, SAMPSIM_MAXIMUM_RR > number_of_selected_diseased_individuals;
   };
 }
 
@@ -0,0 +1,176 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   town_selection.cxx
+  Language: C++
+
+=========================================================================*/
+
+#include "town_selection.h"
+
+#include "utilities.h"
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace sampsim
+{
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void town_selection::set_method( const method_type method )
+  {
+    if( UNKNOWN_METHOD_TYPE == method )
+      throw std::runtime_error( "Tried to select towns using an unknown method" );
+    this->method = method;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void town_selection::set_size_list( const std::vector< unsigned int > &size_list )
+  {
+    const unsigned int n = size_list.size();
+    this->size_list = size_list;
+
+    this->cumulative_list.resize( n );
+    std::partial_sum( size_list.cbegin(), size_list.cend(), this->cumulative_list.begin() );
+
+    // order by size, keeping town order between towns of the same size
+    this->sorted_index_list.resize( n );
+    for( unsigned int index = 0; index < n; index++ ) this->sorted_index_list[index] = index;
+    std::stable_sort(
+      this->sorted_index_list.begin(),
+      this->sorted_index_list.end(),
+      [&size_list]( unsigned int a, unsigned int b ) { return size_list[a] < size_list[b]; } );
+    this->sorted_cumulative_list.resize( n );
+    unsigned int cumulative = 0;
+    for( unsigned int index = 0; index < n; index++ )
+    {
+      cumulative += size_list[this->sorted_index_list[index]];
+      this->sorted_cumulative_list[index] = cumulative;
+    }
+
+    // build the alias table using Vose's method
+    this->alias_probability_list.assign( n, 1.0 );
+    this->alias_list.resize( n );
+    for( unsigned int index = 0; index < n; index++ ) this->alias_list[index] = index;
+    const double total = this->get_total_size();
+    if( 0 < total )
+    {
+      std::vector< double > scaled_list( n );
+      std::vector< unsigned int > small_list, large_list;
+      for( unsigned int index = 0; index < n; index++ )
+      {
+        scaled_list[index] = size_list[index] * n / total;
+        if( 1.0 > scaled_list[index] ) small_list.push_back( index );
+        else large_list.push_back( index );
+      }
+
+      while( !small_list.empty() && !large_list.empty() )
+      {
+        unsigned int small = small_list.back(), large = large_list.back();
+        small_list.pop_back();
+        large_list.pop_back();
+        this->alias_probability_list[small] = scaled_list[small];
+        this->alias_list[small] = large;
+        scaled_list[large] += scaled_list[small] - 1.0;
+        if( 1.0 > scaled_list[large] ) small_list.push_back( large );
+        else large_list.push_back( large );
+      }
+      // anything left over is only due to rounding error so it is always kept
+    }
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  unsigned int town_selection::get_town_index( const unsigned int individual ) const
+  {
+    if( 1 > individual || this->get_total_size() < individual )
+    {
+      std::stringstream stream;
+      stream << "Tried to find the town of individual " << individual << " but there are only "
+             << this->get_total_size() << " individuals";
+      throw std::runtime_error( stream.str() );
+    }
+
+    // the first town whose cumulative size reaches the individual
+    return std::lower_bound( this->cumulative_list.cbegin(), this->cumulative_list.cend(), individual ) -
+           this->cumulative_list.cbegin();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  double town_selection::get_selection_fraction( const unsigned int index ) const
+  {
+    const unsigned int total = this->get_total_size();
+    if( 0 == total ) return 0.0;
+    return SIMPLE_RANDOM == this->method ?
+      1.0 / this->get_number_of_towns() : this->size_list[index] / static_cast< double >( total );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  std::vector< unsigned int > town_selection::select( const unsigned int number_of_towns ) const
+  {
+    const unsigned int total = this->get_total_size();
+    const unsigned int n = this->get_number_of_towns();
+    if( 0 == total )
+      throw std::runtime_error( "Tried to select towns from a population with no individuals" );
+
+    std::vector< unsigned int > index_list;
+    index_list.reserve( number_of_towns );
+    if( SYSTEMATIC_PPS == this->method || STRATIFIED_PPS == this->method )
+    {
+      // both methods divide all individuals into equal intervals, one town is taken from each
+      unsigned int interval = total / number_of_towns;
+      if( 0 == interval )
+      {
+        std::stringstream stream;
+        stream << "Cannot select " << number_of_towns << " towns from only " << total << " individuals";
+        throw std::runtime_error( stream.str() );
+      }
+
+      if( SYSTEMATIC_PPS == this->method )
+      {
+        unsigned int individual = utilities::random( 1, interval );
+        for( unsigned int town = 0; town < number_of_towns; town++, individual += interval )
+          index_list.push_back( this->get_town_index( individual ) );
+      }
+      else
+      {
+        // each interval of the size-ordered list is a stratum with its own random start
+        for( unsigned int town = 0; town < number_of_towns; town++ )
+        {
+          unsigned int individual = town * interval + utilities::random( 1, interval );
+          auto it = std::lower_bound(
+            this->sorted_cumulative_list.cbegin(), this->sorted_cumulative_list.cend(), individual );
+          index_list.push_back( this->sorted_index_list[it - this->sorted_cumulative_list.cbegin()] );
+        }
+      }
+    }
+    else if( PPS_WITH_REPLACEMENT == this->method )
+    {
+      for( unsigned int town = 0; town < number_of_towns; town++ )
+      {
+        unsigned int column = utilities::random( 0, n - 1 );
+        index_list.push_back(
+          utilities::random() < this->alias_probability_list[column] ? column : this->alias_list[column] );
+      }
+    }
+    else if( SIMPLE_RANDOM == this->method )
+    {
+      if( n < number_of_towns )
+      {
+        std::stringstream stream;
+        stream << "Cannot select " << number_of_towns << " towns without replacement from only " << n;
+        throw std::runtime_error( stream.str() );
+      }
+
+      // partial Fisher-Yates shuffle, listing the selected towns in town order
+      std::vector< unsigned int > shuffle_list( n );
+      for( unsigned int index = 0; index < n; index++ ) shuffle_list[index] = index;
+      for( unsigned int town = 0; town < number_of_towns; town++ )
+        std::swap( shuffle_list[town], shuffle_list[utilities::random( town, n - 1 )] );
+      index_list.assign( shuffle_list.begin(), shuffle_list.begin() + number_of_towns );
+      std::sort( index_list.begin(), index_list.end() );
+    }
+
+    return index_list;
+  }
+}
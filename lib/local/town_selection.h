@@ -0,0 +1,165 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   town_selection.h
+  Language: C++
+
+=========================================================================*/
+
+#ifndef __sampsim_town_selection_h
+#define __sampsim_town_selection_h
+
+#include <string>
+#include <vector>
+
+/**
+ * @addtogroup sampsim
+ * @{
+ */
+
+namespace sampsim
+{
+  /**
+   * @class town_selection
+   * @author Patrick Emond <emondpd@mcmaster.ca>
+   * @brief The first stage of a multi-town sample: choosing which towns to sample
+   * @details
+   * Towns are described only by their size (number of individuals) and are referred to by their index in
+   * the population's town list.  The cumulative sizes are stored once so that finding the town containing
+   * any individual is a binary search, and an alias table is built so that drawing towns with probability
+   * proportional to size (PPS) with replacement takes constant time per town.  All random numbers come
+   * from utilities::random_engine so selections are reproducible given the sample's seed.
+   */
+  class town_selection
+  {
+  public:
+    /**
+     * @enum method_type
+     * The ways in which towns can be selected
+     */
+    enum method_type
+    {
+      UNKNOWN_METHOD_TYPE = 0,
+      SYSTEMATIC_PPS, // PPS using a single random start and a fixed interval through the town list
+      PPS_WITH_REPLACEMENT, // independent PPS draws
+      STRATIFIED_PPS, // one PPS draw from each of the strata of equal size formed by towns ordered by size
+      SIMPLE_RANDOM // equal probability without replacement
+    };
+
+    /**
+     * Converts the name of a selection method to its enum value
+     */
+    inline static method_type get_method_type( const std::string name )
+    {
+      if( "systematic" == name ) return SYSTEMATIC_PPS;
+      else if( "pps" == name ) return PPS_WITH_REPLACEMENT;
+      else if( "stratified" == name ) return STRATIFIED_PPS;
+      else if( "simple" == name ) return SIMPLE_RANDOM;
+      return UNKNOWN_METHOD_TYPE;
+    }
+
+    /**
+     * Converts the enum value of a selection method to its name
+     */
+    inline static std::string get_method_type_name( const method_type type )
+    {
+      if( SYSTEMATIC_PPS == type ) return "systematic";
+      else if( PPS_WITH_REPLACEMENT == type ) return "pps";
+      else if( STRATIFIED_PPS == type ) return "stratified";
+      else if( SIMPLE_RANDOM == type ) return "simple";
+      return "unknown";
+    }
+
+    /**
+     * Constructor
+     */
+    town_selection() : method( SYSTEMATIC_PPS ) {}
+
+    /**
+     * Sets the selection method
+     */
+    void set_method( const method_type method );
+
+    /**
+     * Returns the selection method
+     */
+    method_type get_method() const { return this->method; }
+
+    /**
+     * Sets the size of every town, building the look-up tables used by select()
+     */
+    void set_size_list( const std::vector< unsigned int > &size_list );
+
+    /**
+     * Returns the number of towns
+     */
+    unsigned int get_number_of_towns() const { return this->cumulative_list.size(); }
+
+    /**
+     * Returns the total size of all towns
+     */
+    unsigned int get_total_size() const
+    { return this->cumulative_list.empty() ? 0 : this->cumulative_list.back(); }
+
+    /**
+     * Returns the index of the town containing an individual, numbering individuals from 1 in town order
+     */
+    unsigned int get_town_index( const unsigned int individual ) const;
+
+    /**
+     * Returns a town's probability of being chosen by a single draw
+     *
+     * This is the town's fraction of the total size for all PPS methods and one over the number of towns
+     * for simple random selection.  It is 0 when the towns are empty.
+     */
+    double get_selection_fraction( const unsigned int index ) const;
+
+    /**
+     * Selects towns, returning their indices
+     *
+     * All PPS methods may select the same (large) town more than once.  Throws an exception if there are
+     * no towns or if more towns are requested than exist when selecting without replacement.
+     */
+    std::vector< unsigned int > select( const unsigned int number_of_towns ) const;
+
+  private:
+    /**
+     * The selection method
+     */
+    method_type method;
+
+    /**
+     * The size of every town
+     */
+    std::vector< unsigned int > size_list;
+
+    /**
+     * The cumulative size of every town, in town order
+     */
+    std::vector< unsigned int > cumulative_list;
+
+    /**
+     * The index of every town ordered by size (smallest first, used by stratified selection)
+     */
+    std::vector< unsigned int > sorted_index_list;
+
+    /**
+     * The cumulative size of every town ordered by size
+     */
+    std::vector< unsigned int > sorted_cumulative_list;
+
+    /**
+     * The probability of keeping each column of the alias table (used by PPS with replacement)
+     */
+    std::vector< double > alias_probability_list;
+
+    /**
+     * The town chosen instead when a column of the alias table is not kept
+     */
+    std::vector< unsigned int > alias_list;
+  };
+}
+
+/** @} end of doxygen group */
+
+#endif
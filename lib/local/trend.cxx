@@ -58,7 +58,7 @@ namespace sampsim
   //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
   void trend::initialize_distributions()
   {
-    this->debug( "initialize_distributions()" );
+    SAMPSIM_DEBUG( "initialize_distributions()" );
     for( unsigned int index = 0; index < 6; index++ )
     {
       this->dist[index].set_normal(
@@ -77,7 +77,7 @@ namespace sampsim
                    this->get_b02() * c.x * c.x +
                    this->get_b20() * c.y * c.y +
                    this->get_b11() * c.x * c.y;
-    this->debug( "get_value( coordinate = (%f,%f) ) = %s = %f", c.x, c.y, this->to_string().c_str(), value );
+    SAMPSIM_TRACE( "get_value( coordinate = (%f,%f) ) = %s = %f", c.x, c.y, this->to_string().c_str(), value );
     return value;
   }
 
@@ -95,7 +95,7 @@ namespace sampsim
     if( std::isnan( this->b[index][3] ) )
     {
       this->b[index][3] = this->dist[index].generate_value();
-      this->debug( "get_constant( index = %d ) caching value of %f", index, this->b[index][3] );
+      SAMPSIM_TRACE( "get_constant( index = %d ) caching value of %f", index, this->b[index][3] );
     }
 
     return this->b[index][3];
@@ -154,7 +154,7 @@ namespace sampsim
       throw std::runtime_error( stream.str() );
     }
 
-    this->debug(
+    SAMPSIM_DEBUG(
       "set_coefficient( index=%d, value=%f, regression=%f, variance=%f )",
       index, value, regression, variance );
     this->b[index][0] = value;
@@ -0,0 +1,135 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   trend_field.cxx
+  Language: C++
+
+=========================================================================*/
+
+#include "trend_field.h"
+
+#include "coordinate.h"
+#include "trend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace sampsim
+{
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  trend_field::trend_field()
+  {
+    this->set = false;
+    for( unsigned int index = 0; index < 6; index++ )
+      for( unsigned int f = 0; f < NUMBER_OF_FIELDS; f++ )
+        this->coefficient[index][f] = 0.0;
+    this->lattice_x = 0.0;
+    this->lattice_y = 0.0;
+    this->lattice_spacing = 0.0;
+    this->lattice_width = 0;
+    this->lattice_height = 0;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void trend_field::set_trends( trend* const trend_list[NUMBER_OF_FIELDS] )
+  {
+    for( unsigned int f = 0; f < NUMBER_OF_FIELDS; f++ )
+      for( unsigned int index = 0; index < 6; index++ )
+        this->coefficient[index][f] = trend_list[f]->get_constant( index );
+    this->set = true;
+    this->clear_lattice();
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void trend_field::build_lattice( const coordinate lower, const coordinate upper, const double spacing )
+  {
+    if( !this->set ) throw std::runtime_error( "Tried to build a lattice for a trend field with no trends" );
+    if( 0 >= spacing ) throw std::runtime_error( "Tried to build a trend field lattice with no spacing" );
+
+    this->lattice.clear();
+    this->lattice_x = lower.x;
+    this->lattice_y = lower.y;
+    this->lattice_spacing = spacing;
+    this->lattice_width = std::max( 2.0, std::ceil( ( upper.x - lower.x ) / spacing ) + 1 );
+    this->lattice_height = std::max( 2.0, std::ceil( ( upper.y - lower.y ) / spacing ) + 1 );
+
+    std::vector< double > lattice( this->lattice_width * this->lattice_height * NUMBER_OF_FIELDS );
+    double *values = lattice.data();
+    for( std::size_t j = 0; j < this->lattice_height; j++ )
+    {
+      for( std::size_t i = 0; i < this->lattice_width; i++, values += NUMBER_OF_FIELDS )
+      {
+        this->evaluate_exact(
+          this->lattice_x + i * this->lattice_spacing,
+          this->lattice_y + j * this->lattice_spacing,
+          values );
+      }
+    }
+
+    this->lattice.swap( lattice );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void trend_field::clear_lattice()
+  {
+    this->lattice.clear();
+    this->lattice_width = 0;
+    this->lattice_height = 0;
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void trend_field::evaluate( const coordinate &position, double *values ) const
+  {
+    this->evaluate( 1, &position, values );
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void trend_field::evaluate( const std::size_t count, const coordinate *positions, double *values ) const
+  {
+    if( !this->set ) throw std::runtime_error( "Tried to evaluate a trend field with no trends" );
+
+    if( !this->has_lattice() )
+    {
+      for( std::size_t n = 0; n < count; n++, values += NUMBER_OF_FIELDS )
+        this->evaluate_exact( positions[n].x, positions[n].y, values );
+      return;
+    }
+
+    const double max_i = this->lattice_width - 1, max_j = this->lattice_height - 1;
+    const std::size_t row = this->lattice_width * NUMBER_OF_FIELDS;
+    for( std::size_t n = 0; n < count; n++, values += NUMBER_OF_FIELDS )
+    {
+      // positions outside of the lattice are clamped to its edge
+      double fi = ( positions[n].x - this->lattice_x ) / this->lattice_spacing;
+      double fj = ( positions[n].y - this->lattice_y ) / this->lattice_spacing;
+      fi = std::min( max_i, std::max( 0.0, fi ) );
+      fj = std::min( max_j, std::max( 0.0, fj ) );
+      std::size_t i = std::min( max_i - 1, std::floor( fi ) );
+      std::size_t j = std::min( max_j - 1, std::floor( fj ) );
+      double tx = fi - i, ty = fj - j;
+
+      const double *v00 = this->lattice.data() + j * row + i * NUMBER_OF_FIELDS;
+      const double *v10 = v00 + NUMBER_OF_FIELDS;
+      const double *v01 = v00 + row;
+      const double *v11 = v01 + NUMBER_OF_FIELDS;
+      for( unsigned int f = 0; f < NUMBER_OF_FIELDS; f++ )
+      {
+        values[f] = ( 1 - ty ) * ( ( 1 - tx ) * v00[f] + tx * v10[f] ) +
+                    ty * ( ( 1 - tx ) * v01[f] + tx * v11[f] );
+      }
+    }
+  }
+
+  //-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-+#+-
+  void trend_field::evaluate_exact( const double x, const double y, double *values ) const
+  {
+    // the terms are added in the same order as trend::get_value() so that results are identical
+    for( unsigned int f = 0; f < NUMBER_OF_FIELDS; f++ ) values[f] = this->coefficient[0][f];
+    for( unsigned int f = 0; f < NUMBER_OF_FIELDS; f++ ) values[f] += this->coefficient[1][f] * x;
+    for( unsigned int f = 0; f < NUMBER_OF_FIELDS; f++ ) values[f] += this->coefficient[2][f] * y;
+    for( unsigned int f = 0; f < NUMBER_OF_FIELDS; f++ ) values[f] += this->coefficient[3][f] * x * x;
+    for( unsigned int f = 0; f < NUMBER_OF_FIELDS; f++ ) values[f] += this->coefficient[4][f] * y * y;
+    for( unsigned int f = 0; f < NUMBER_OF_FIELDS; f++ ) values[f] += this->coefficient[5][f] * x * y;
+  }
+}
@@ -0,0 +1,150 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   trend_field.h
+  Language: C++
+
+=========================================================================*/
+
+#ifndef __sampsim_trend_field_h
+#define __sampsim_trend_field_h
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @addtogroup sampsim
+ * @{
+ */
+
+namespace sampsim
+{
+  class coordinate;
+  class trend;
+
+  /**
+   * @class trend_field
+   * @author Patrick Emond <emondpd@mcmaster.ca>
+   * @brief The six trends which describe a town's income, disease and exposure evaluated together
+   * @details
+   * Households need the value of all six of their town's income and risk trends at their building's
+   * position.  Rather than calling trend::get_value() six times per household a town bakes the
+   * trends' constants into a single coefficient table and evaluates all of them at once for a batch
+   * of positions.  The values are calculated in the same way as trend::get_value() so the results
+   * are identical.
+   *
+   * For very large towns the field can instead be sampled on a lattice, in which case values are
+   * bilinearly interpolated between the four nearest lattice points.  This is an approximation and
+   * is only used when build_lattice() is called.
+   */
+  class trend_field
+  {
+  public:
+    /**
+     * The order of the fields in every array of values
+     */
+    enum field_type
+    {
+      MEAN_INCOME = 0,
+      SD_INCOME,
+      MEAN_DISEASE,
+      SD_DISEASE,
+      MEAN_EXPOSURE,
+      SD_EXPOSURE,
+      NUMBER_OF_FIELDS
+    };
+
+    /**
+     * Constructor
+     */
+    trend_field();
+
+    /**
+     * Bakes the coefficients of a list of trends (in field order)
+     *
+     * Trend constants are cached the first time they are used, which may generate random values,
+     * so the constants are requested one trend at a time in field order.
+     */
+    void set_trends( trend* const trend_list[NUMBER_OF_FIELDS] );
+
+    /**
+     * Returns whether set_trends() has been called
+     */
+    bool is_set() const { return this->set; }
+
+    /**
+     * Samples the field on a lattice covering the given bounds with the given spacing
+     *
+     * Once built all evaluations are interpolated from the lattice.
+     */
+    void build_lattice( const coordinate lower, const coordinate upper, const double spacing );
+
+    /**
+     * Removes the lattice so that values are evaluated exactly
+     */
+    void clear_lattice();
+
+    /**
+     * Returns whether the field's values are interpolated from a lattice
+     */
+    bool has_lattice() const { return !this->lattice.empty(); }
+
+    /**
+     * Evaluates all fields at a single position
+     *
+     * The values array must have room for NUMBER_OF_FIELDS values.
+     */
+    void evaluate( const coordinate &position, double *values ) const;
+
+    /**
+     * Evaluates all fields at a list of positions
+     *
+     * The values array must have room for count * NUMBER_OF_FIELDS values, the fields of the first
+     * position are followed by those of the second, etc.
+     */
+    void evaluate( const std::size_t count, const coordinate *positions, double *values ) const;
+
+  protected:
+    /**
+     * Evaluates all fields exactly (without using the lattice)
+     */
+    void evaluate_exact( const double x, const double y, double *values ) const;
+
+  private:
+    /**
+     * Whether the coefficients have been set
+     */
+    bool set;
+
+    /**
+     * The six trend constants (b00, b01, b10, b02, b20, b11) of each field
+     *
+     * Stored constant-major so that each term is applied to all fields in a single loop.
+     */
+    double coefficient[6][NUMBER_OF_FIELDS];
+
+    /**
+     * The lower corner of the lattice
+     */
+    double lattice_x, lattice_y;
+
+    /**
+     * The distance between lattice points
+     */
+    double lattice_spacing;
+
+    /**
+     * The number of lattice points in each direction
+     */
+    std::size_t lattice_width, lattice_height;
+
+    /**
+     * The field values at each lattice point, row by row
+     */
+    std::vector< double > lattice;
+  };
+}
+
+/** @} end of doxygen group */
+
+#endif
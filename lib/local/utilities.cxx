@@ -13,14 +13,19 @@
 
 namespace sampsim
 {
-  std::mt19937 sampsim::utilities::random_engine;
+  thread_local std::mt19937 sampsim::utilities::random_engine;
+  std::mutex sampsim::utilities::output_mutex;
   sampsim::utilities::safe_delete_type sampsim::utilities::safe_delete;
   bool sampsim::utilities::verbose = false; 
   bool sampsim::utilities::quiet = false; 
   unsigned int sampsim::utilities::write_sample_number = 1;
   clock_t sampsim::utilities::start_time = clock();
 
-  // define how many diseases (and their relative-risk value) here
-  double rr_values[] = { 1.0, 1.5, 2.0, 3.0 };
-  std::vector< double > sampsim::utilities::rr( rr_values, rr_values + sizeof(rr_values)/sizeof(double) );
+  // the default diseases (and their relative-risk value), see set_rr()
+  rr_list_type sampsim::utilities::rr{ 1.0, 1.5, 2.0, 3.0 };
+
+  // archives are written as gzip using all available processors by default
+  compression_type sampsim::utilities::compression = GZIP_COMPRESSION;
+  int sampsim::utilities::compression_level = 6;
+  unsigned int sampsim::utilities::compression_threads = 0;
 }
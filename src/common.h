@@ -106,6 +106,135 @@ std::string gnuplot(
   return gnuplot( town, population_name, -1, sample_name );
 }
 
+void setup_compression( sampsim::options &opts )
+{
+  opts.add_heading( "" );
+  opts.add_heading( "Archive compression parameters:" );
+  opts.add_heading( "" );
+  opts.add_option( "compression", "gzip",
+    "The codec used to compress archives (\"gzip\", \"zstd\" or \"lz4\", the latter two are faster but "
+    "depend on how libarchive was built)" );
+  opts.add_option( "compression_level", "6", "The compression level (0 to 9, higher is smaller but slower)" );
+  opts.add_option( "compression_threads", "0",
+    "The number of threads used to compress gzip archives (0 will use all processors)" );
+}
+
+bool process_compression( sampsim::options &opts )
+{
+  std::string name = opts.get_option( "compression" );
+  sampsim::compression_type type = sampsim::get_compression_type( name );
+  int level = opts.get_option_as_int( "compression_level" );
+  int threads = opts.get_option_as_int( "compression_threads" );
+
+  if( sampsim::UNKNOWN_COMPRESSION_TYPE == type )
+  {
+    std::cout << "ERROR: unknown compression type \"" << name << "\"" << std::endl;
+  }
+  else if( !sampsim::utilities::is_compression_available( type ) )
+  {
+    std::cout << "ERROR: " << name << " compression is not available, libarchive must be built with "
+              << name << " support in order to use it" << std::endl;
+  }
+  else if( 0 > level || 9 < level )
+  {
+    std::cout << "ERROR: compression level must be between 0 and 9" << std::endl;
+  }
+  else if( 0 > threads )
+  {
+    std::cout << "ERROR: the number of compression threads cannot be negative" << std::endl;
+  }
+  else
+  {
+    sampsim::utilities::compression = type;
+    sampsim::utilities::compression_level = level;
+    sampsim::utilities::compression_threads = threads;
+    return true;
+  }
+
+  return false;
+}
+
+void setup_rr( sampsim::options &opts )
+{
+  opts.add_heading( "" );
+  opts.add_heading( "Disease relative risk parameters:" );
+  opts.add_heading( "" );
+  opts.add_option( "rr", std::vector< std::string >(),
+    "Comma-separated list of the relative risks of exposed individuals, one disease status is stored for "
+    "each (default is 1,1.5,2,3, files can only be read using the same list they were written with)" );
+}
+
+bool process_rr( sampsim::options &opts )
+{
+  std::vector< double > rr_list = opts.get_option_as_double_list( "rr" );
+  if( rr_list.empty() ) return true; // keep the default list
+
+  for( auto it = rr_list.cbegin(); it != rr_list.cend(); ++it )
+  {
+    if( 0 >= *it )
+    {
+      std::cout << "ERROR: relative risks must be greater than 0" << std::endl;
+      return false;
+    }
+  }
+
+  try
+  {
+    sampsim::utilities::set_rr( rr_list );
+  }
+  catch( std::runtime_error &e )
+  {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+void setup_stratification( sampsim::options &opts )
+{
+  opts.add_heading( "" );
+  opts.add_heading( "Stratified summary parameters (a .stratified.csv file is written if any are set):" );
+  opts.add_heading( "" );
+  opts.add_option( "income_quantiles", std::vector< std::string >(),
+    "Comma-separated bin edges of households' income quantile within their town (between 0 and 1)" );
+  opts.add_option( "household_sizes", std::vector< std::string >(),
+    "Comma-separated bin edges of the number of individuals in households" );
+  opts.add_option( "pocket_distances", std::vector< std::string >(),
+    "Comma-separated bin edges of the distance from households to their town's nearest disease pocket" );
+}
+
+// sets the dimensions of a stratified summary (leaving it without any if none were requested)
+bool process_stratification( const sampsim::options &opts, sampsim::stratified_summary *stratified )
+{
+  typedef sampsim::stratified_summary cube;
+  static const std::pair< std::string, cube::dimension_type > option_list[] = {
+    { "income_quantiles", cube::INCOME_QUANTILE },
+    { "household_sizes", cube::HOUSEHOLD_SIZE },
+    { "pocket_distances", cube::POCKET_DISTANCE }
+  };
+
+  stratified->clear();
+  try
+  {
+    for( auto it = std::begin( option_list ); it != std::end( option_list ); ++it )
+    {
+      std::vector< double > edge_list = opts.get_option_as_double_list( it->first );
+      if( edge_list.empty() ) continue;
+      if( cube::INCOME_QUANTILE == it->second && ( 0 >= edge_list.front() || 1 <= edge_list.back() ) )
+        throw std::runtime_error( "Income quantile bin edges must be between 0 and 1" );
+      stratified->add_dimension( it->second, edge_list );
+    }
+  }
+  catch( std::runtime_error &e )
+  {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 void setup_sample( sampsim::options &opts )
 {
   // define inputs
@@ -136,6 +265,17 @@ void setup_sample( sampsim::options &opts )
   opts.add_option( "towns", "1", "For multi-town populations, the number of towns to sample" );
   opts.add_option( "size", "1000", "How many individuals to select in each sample" );
   opts.add_flag( "resample_towns", "Resample towns with every sample iteration" );
+  opts.add_option( "town_selection", "systematic",
+    "How towns are selected (\"systematic\", \"pps\", \"stratified\" or \"simple\")" );
+  opts.add_flag( "coverage", "Write the confidence interval coverage of each variance estimator" );
+  opts.add_option( "bootstrap_replicates", "0",
+    "Number of bootstrap replicates drawn for every sample when writing coverage (0 for no bootstrap, "
+    "otherwise at least 2)" );
+  opts.add_option( "variance_threads", "1", "Number of threads drawing bootstrap replicates" );
+
+  setup_rr( opts );
+  setup_stratification( opts );
+  setup_compression( opts );
 }
 
 void process_sample( sampsim::options &opts, sampsim::sample::sized_sample *sample )
@@ -167,7 +307,22 @@ void process_sample( sampsim::options &opts, sampsim::sample::sized_sample *samp
     std::cout << "ERROR: requested part " << part_list[0] << " must be between 1 and the total number of parts ("
               << part_list[1] << ")" << std::endl;
   }
-  else
+  else if( 0 > opts.get_option_as_int( "bootstrap_replicates" ) ||
+           1 == opts.get_option_as_int( "bootstrap_replicates" ) ||
+           1 > opts.get_option_as_int( "variance_threads" ) )
+  {
+    std::cout << "ERROR: bootstrap_replicates must be 0 or at least 2 and variance_threads must be 1 or greater"
+              << std::endl;
+  }
+  else if( sampsim::town_selection::UNKNOWN_METHOD_TYPE ==
+           sampsim::town_selection::get_method_type( opts.get_option( "town_selection" ) ) )
+  {
+    std::cout << "ERROR: town_selection must be \"systematic\", \"pps\", \"stratified\" or \"simple\""
+              << std::endl;
+  }
+  else if( process_rr( opts ) &&
+           process_stratification( opts, sample->get_stratified_summary() ) &&
+           process_compression( opts ) )
   {
     std::string population_filename = opts.get_input( "population_file" );
     std::string output_filename = opts.get_input( "output_file" );
@@ -188,6 +343,13 @@ void process_sample( sampsim::options &opts, sampsim::sample::sized_sample *samp
     sample->set_number_of_towns( opts.get_option_as_int( "towns" ) );
     sample->set_size( opts.get_option_as_int( "size" ) );
     sample->set_resample_towns( opts.get_flag( "resample_towns" ) );
+    sample->set_town_selection_method(
+      sampsim::town_selection::get_method_type( opts.get_option( "town_selection" ) ) );
+    sample->set_summary_only( summary_only );
+    sample->set_coverage( opts.get_flag( "coverage" ) );
+    sample->set_design_effect( summary );
+    sample->set_bootstrap_replicates( opts.get_option_as_int( "bootstrap_replicates" ) );
+    sample->set_variance_threads( opts.get_option_as_int( "variance_threads" ) );
 
     if( sample->set_population( population_filename ) )
     {
@@ -201,8 +363,16 @@ void process_sample( sampsim::options &opts, sampsim::sample::sized_sample *samp
       {
         sample->write_summary( output_filename );
         sample->write_variance( output_filename );
+        sample->write_design_effect( output_filename );
       }
 
+      // create a coverage file if requested
+      if( opts.get_flag( "coverage" ) ) sample->write_coverage( output_filename );
+
+      // create a stratified summary file if any strata were requested
+      if( 0 < sample->get_stratified_summary()->get_number_of_dimensions() )
+        sample->write_stratified_summary( output_filename );
+
       // create a flat file if a flat file or plot was requested
       if( !summary_only && ( flat || plot ) ) sample->write( output_filename, true );
         
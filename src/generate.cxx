@@ -17,7 +17,216 @@
 #include "trend.h"
 #include "utilities.h"
 
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+
+// returns the name of a population's files (numbered when generating a batch of populations)
+std::string get_population_filename( const std::string filename, const int p, const int populations )
+{
+  if( 1 == populations ) return filename;
+
+  std::stringstream stream;
+  stream << filename << ".p" << std::setw( log( populations+1 ) ) << std::setfill( '0' ) << p;
+  return stream.str();
+}
+
+// generates a population using whichever method the options call for
+void generate_population(
+  const sampsim::options &opts,
+  sampsim::population *population,
+  const sampsim::population *parameters,
+  const std::string population_filename )
+{
+  // strata must be known before generating since streamed towns are discarded once they are counted
+  process_stratification( opts, population->get_stratified_summary() );
+
+  // when only the summary is needed there is no reason to keep the whole population in memory
+  if( opts.get_flag( "stream" ) ) population->generate_streaming( population_filename );
+  else if( NULL != parameters ) population->redefine( parameters );
+  else if( opts.get_flag( "summary_file_only" ) ) population->generate_summary();
+  else population->generate();
+}
+
+// writes all requested files for a population which has already been generated
+void write_population(
+  const sampsim::options &opts,
+  sampsim::population *population,
+  const std::string population_filename )
+{
+  bool stream = opts.get_flag( "stream" );
+  bool flat = opts.get_flag( "flat_file" );
+  bool flat_only = opts.get_flag( "flat_file_only" );
+  if( flat_only ) flat = true;
+  bool summary = opts.get_flag( "summary_file" );
+  bool summary_only = opts.get_flag( "summary_file_only" );
+  if( summary_only ) summary = true;
+  bool plot = GNUPLOT_AVAILABLE ? opts.get_flag( "plot" ) : false;
+
+  // create a json file unless a flat file only was requested (streamed populations are already written)
+  if( !stream && !flat_only && !summary_only ) population->write( population_filename, false );
+  
+  // create a flat file if a flat file or plot was requested
+  if( !summary_only && ( flat || plot ) ) population->write( population_filename, true );
+
+  // create a summary file if requested
+  if( summary ) population->write_summary( population_filename );
+
+  // create a stratified summary file if any strata were requested
+  if( 0 < population->get_stratified_summary()->get_number_of_dimensions() )
+    population->write_stratified_summary( population_filename );
+
+  // plot the flat file if requested to
+  if( !summary_only && plot )
+  {
+
+    if( 1 == population->get_number_of_towns() )
+    {
+      std::string result = sampsim::utilities::exec(
+        gnuplot( *( population->get_town_list_cbegin() ), population_filename ) );
+      if( "ERROR" == result ) sampsim::utilities::output( "warning: failed to create plot" );
+      else sampsim::utilities::output( "creating plot file" );
+    }
+    else
+    {
+      std::stringstream stream;
+      unsigned int index = 0;
+      for( auto it = population->get_town_list_cbegin();
+           it != population->get_town_list_cend();
+           ++it, ++index )
+      {
+        sampsim::town *town = *it;
+        std::string result = sampsim::utilities::exec( gnuplot( town, population_filename, index ) );
+
+        stream.str( "" );
+        stream << population_filename << ".t"
+               << std::setw( log( population->get_number_of_towns()+1 ) )
+               << std::setfill( '0' ) << index << ".png";
+        std::string image_filename = stream.str();
+
+        stream.str( "" );
+        if( "ERROR" == result ) stream << "warning: failed to create plot";
+        else stream << "creating plot file \"" << image_filename << "\"";
+        sampsim::utilities::output( stream.str() );
+      }
+    }
+  }
+}
+
+// generates a batch of populations in worker threads while the calling thread writes them in order
+// Each population is seeded by the base seed plus its index so that population p is identical to the
+// population generated on its own using that seed.  Workers do not start a new population while
+// queue_size finished populations are waiting to be written, which limits how many populations are
+// held in memory at once to roughly the number of threads plus the queue size.
+void generate_pipelined(
+  const sampsim::options &opts,
+  const sampsim::population *parameters,
+  const std::string filename,
+  const int populations,
+  const unsigned int threads,
+  const unsigned int queue_size )
+{
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::map< int, sampsim::population* > finished_map;
+  std::exception_ptr error;
+  int next = 0;
+  const int seed = atoi( parameters->get_seed().c_str() );
+  const std::string geometry_filename = opts.get_option( "reuse_geometry" );
+
+  auto worker = [&]()
+  {
+    while( true )
+    {
+      int p;
+      {
+        std::unique_lock< std::mutex > lock( mutex );
+        condition.wait( lock, [&]() { return error || finished_map.size() < queue_size; } );
+        if( error || populations <= next ) return;
+        p = next++;
+      }
+
+      {
+        std::lock_guard< std::mutex > lock( sampsim::utilities::output_mutex );
+        std::cout << "generating population " << ( p+1 ) << " of " << populations << std::endl;
+      }
+
+      // the engine is seeded in this thread since each thread has its own random engine
+      sampsim::population *population = new sampsim::population;
+      sampsim::population *seeded = NULL;
+      try
+      {
+        std::stringstream stream;
+        stream << ( seed + p );
+        population->copy_parameters( parameters );
+        population->set_seed( stream.str() );
+
+        // when reusing geometry the seeded population only provides parameters to the one read from disk
+        if( !geometry_filename.empty() )
+        {
+          seeded = population;
+          population = new sampsim::population;
+          if( !population->read( geometry_filename ) )
+            throw std::runtime_error( "ERROR: unable to read geometry file \"" + geometry_filename + "\"" );
+        }
+
+        generate_population( opts, population, seeded, get_population_filename( filename, p, populations ) );
+        sampsim::utilities::safe_delete( seeded );
+      }
+      catch( ... )
+      {
+        sampsim::utilities::safe_delete( population );
+        sampsim::utilities::safe_delete( seeded );
+        std::lock_guard< std::mutex > lock( mutex );
+        if( !error ) error = std::current_exception();
+        condition.notify_all();
+        return;
+      }
+
+      std::lock_guard< std::mutex > lock( mutex );
+      finished_map[p] = population;
+      condition.notify_all();
+    }
+  };
+
+  std::vector< std::thread > thread_list;
+  for( unsigned int t = 0; t < threads; t++ ) thread_list.push_back( std::thread( worker ) );
+
+  // write populations in order as they become available
+  for( int p = 0; p < populations; p++ )
+  {
+    sampsim::population *population = NULL;
+    {
+      std::unique_lock< std::mutex > lock( mutex );
+      condition.wait( lock, [&]() { return error || finished_map.count( p ); } );
+      if( error ) break;
+      population = finished_map[p];
+      finished_map.erase( p );
+      condition.notify_all();
+    }
+
+    try
+    {
+      write_population( opts, population, get_population_filename( filename, p, populations ) );
+    }
+    catch( ... )
+    {
+      std::lock_guard< std::mutex > lock( mutex );
+      if( !error ) error = std::current_exception();
+      condition.notify_all();
+    }
+    sampsim::utilities::safe_delete( population );
+    if( error ) break;
+  }
+
+  for( auto it = thread_list.begin(); it != thread_list.end(); ++it ) it->join();
+  for( auto it = finished_map.begin(); it != finished_map.end(); ++it )
+    sampsim::utilities::safe_delete( it->second );
+  if( error ) std::rethrow_exception( error );
+}
 
 // main function
 int main( const int argc, const char** argv )
@@ -25,6 +234,7 @@ int main( const int argc, const char** argv )
   int status = EXIT_FAILURE;
   sampsim::options opts( argv[0] );
   sampsim::population *population = new sampsim::population;
+  sampsim::population *parameters = NULL;
 
   // define inputs
   opts.add_input( "output" );
@@ -36,6 +246,7 @@ int main( const int argc, const char** argv )
   opts.add_flag( 'S', "summary_file_only", "Whether to output summary data only, ommitting population data" );
   if( GNUPLOT_AVAILABLE )
     opts.add_flag( 'p', "plot", "Whether to create a plot of the population (will create a flat-file)" );
+  opts.add_flag( "stream", "Write each town as soon as it is generated to limit memory use (JSON output only)" );
   opts.add_flag( 'v', "verbose", "Be verbose when generating population" );
   opts.add_flag( 'q', "quiet", "Do not generate any output" );
 
@@ -45,6 +256,12 @@ int main( const int argc, const char** argv )
   opts.add_heading( "" );
   opts.add_option( "seed", "", "Seed used by the random generator" );
   opts.add_option( "populations", "1", "Number of populations to generate" );
+  opts.add_option( "pipeline_threads", "0",
+    "Number of threads generating a batch of populations while they are written (0 to generate one at a time)" );
+  opts.add_option( "pipeline_queue", "2",
+    "Maximum number of generated populations waiting to be written when using pipeline_threads" );
+  opts.add_option( "reuse_geometry", "",
+    "Redefine an existing population file instead of creating new towns (only define parameters are used)" );
   opts.add_option( "target_prevalence", "0.5", "The population's target mean disease prevalence" );
   opts.add_option( "towns", "1", "Number of towns to generate" );
   opts.add_option( "town_size_min", "10000", "The minimum number of individuals in a town" );
@@ -61,6 +278,10 @@ int main( const int argc, const char** argv )
   opts.add_option( "disease_pockets", "0", "Number of disease pockets to generate" );
   opts.add_option( "pocket_kernel_type", "exponential", "The type of kernel to use for disease pockets" );
   opts.add_option( "pocket_scaling", "1", "The scaling factor to use for disease pocket" );
+  opts.add_option( "pocket_cutoff", "0",
+    "Ignore disease pockets further than this many scaled distances away (0 to include all pockets)" );
+  opts.add_option( "trend_lattice", "0",
+    "Approximate trends on a lattice with this many cells per tile width (0 to evaluate exactly)" );
   opts.add_heading( "" );
   opts.add_heading( "Population trends:" );
   opts.add_heading( "" );
@@ -136,6 +357,10 @@ int main( const int argc, const char** argv )
   opts.add_option( "dweight_sex", "1.0", "Disease weight for household sex" );
   opts.add_option( "dweight_pocket", "1.0", "Disease weight for pocketing" );
 
+  setup_rr( opts );
+  setup_stratification( opts );
+  setup_compression( opts );
+
   try
   {
     // parse the command line arguments
@@ -158,6 +383,9 @@ int main( const int argc, const char** argv )
         double target_prevalence = opts.get_option_as_double( "target_prevalence" );
         double river_width = opts.get_option_as_double( "river_width" ) / 1000;
         double tile_width = opts.get_option_as_double( "tile_width" );
+        bool stream = opts.get_flag( "stream" );
+        int pipeline_threads = opts.get_option_as_int( "pipeline_threads" );
+        int pipeline_queue = opts.get_option_as_int( "pipeline_queue" );
 
         if( 0 >= tile_width )
         {
@@ -178,7 +406,24 @@ int main( const int argc, const char** argv )
                     << "       Make sure to set tile_width > river_width."
                     << std::endl;
         }
-        else
+        else if( stream &&
+                 ( opts.get_flag( "flat_file" ) || opts.get_flag( "flat_file_only" ) ||
+                   opts.get_flag( "summary_file_only" ) || ( GNUPLOT_AVAILABLE && opts.get_flag( "plot" ) ) ||
+                   !opts.get_option( "reuse_geometry" ).empty() ) )
+        {
+          std::cout << "ERROR: Streaming generation only writes JSON population files. "
+                    << std::endl
+                    << "       Make sure not to request flat files, plots, summary-only output or reuse_geometry."
+                    << std::endl;
+        }
+        else if( 0 > pipeline_threads || 1 > pipeline_queue )
+        {
+          std::cout << "ERROR: Pipeline threads must be >= 0 and pipeline queue must be > 0."
+                    << std::endl;
+        }
+        else if( process_rr( opts ) &&
+                 process_stratification( opts, population->get_stratified_summary() ) &&
+                 process_compression( opts ) )
         {
           if( !sampsim::utilities::quiet )
             std::cout << "sampsim generate version " << sampsim::utilities::get_version() << std::endl;
@@ -208,6 +453,8 @@ int main( const int argc, const char** argv )
           population->set_number_of_disease_pockets( opts.get_option_as_int( "disease_pockets" ) );
           population->set_pocket_kernel_type( opts.get_option( "pocket_kernel_type" ) );
           population->set_pocket_scaling( opts.get_option_as_double( "pocket_scaling" ) );
+          population->set_pocket_cutoff( opts.get_option_as_double( "pocket_cutoff" ) );
+          population->set_trend_lattice_resolution( opts.get_option_as_int( "trend_lattice" ) );
 
           // build trends
           sampsim::trend *mean_income = population->get_mean_income();
@@ -255,73 +502,41 @@ int main( const int argc, const char** argv )
           sd_exposure->set_b20( opts.get_option_as_double_list( "sd_exposure_b20" ) );
           sd_exposure->set_b11( opts.get_option_as_double_list( "sd_exposure_b11" ) );
 
-          std::string population_filename;
-          for( int p = 0; p < populations; p++ )
+          // populations are generated one at a time unless a pipeline was requested for a batch
+          if( 0 < pipeline_threads && 1 < populations )
           {
-            // filename depends on whether we are creating a batch of populations or not
-            if( 1 < populations )
+            generate_pipelined( opts, population, filename, populations, pipeline_threads, pipeline_queue );
+          }
+          else
+          {
+            // when reusing geometry the population is read from disk and the parameters above are only
+            // used to redefine it
+            bool ready = true;
+            std::string geometry_filename = opts.get_option( "reuse_geometry" );
+            if( !geometry_filename.empty() )
             {
-              std::stringstream stream;
-              stream << filename << ".p"
-                     << std::setw( log( populations+1 ) ) << std::setfill( '0' ) << p;
-              population_filename = stream.str();
-              std::cout << "generating population " << ( p+1 ) << " of " << populations << std::endl;
+              parameters = population;
+              population = new sampsim::population;
+              ready = population->read( geometry_filename );
             }
-            else population_filename = filename;
-
-            population->generate();
-
-            bool flat = opts.get_flag( "flat_file" );
-            bool flat_only = opts.get_flag( "flat_file_only" );
-            if( flat_only ) flat = true;
-            bool summary = opts.get_flag( "summary_file" );
-            bool summary_only = opts.get_flag( "summary_file_only" );
-            if( summary_only ) summary = true;
-            bool plot = GNUPLOT_AVAILABLE ? opts.get_flag( "plot" ) : false;
-
-            // create a json file unless a flat file only was requested
-            if( !flat_only && !summary_only ) population->write( population_filename, false );
-            
-            // create a flat file if a flat file or plot was requested
-            if( !summary_only && ( flat || plot ) ) population->write( population_filename, true );
-
-            // create a summary file if requested
-            if( summary ) population->write_summary( population_filename );
 
-            // plot the flat file if requested to
-            if( !summary_only && plot )
+            // each population in a batch is seeded by the base seed plus its index, as when pipelined,
+            // so that the seed written to every population's file reproduces it
+            sampsim::population *seeded = NULL != parameters ? parameters : population;
+            const int seed = atoi( seeded->get_seed().c_str() );
+            for( int p = 0; ready && p < populations; p++ )
             {
-
-              if( 1 == population->get_number_of_towns() )
-              {
-                std::string result = sampsim::utilities::exec(
-                  gnuplot( *( population->get_town_list_cbegin() ), population_filename ) );
-                if( "ERROR" == result ) sampsim::utilities::output( "warning: failed to create plot" );
-                else sampsim::utilities::output( "creating plot file" );
-              }
-              else
+              std::string population_filename = get_population_filename( filename, p, populations );
+              if( 1 < populations )
               {
+                std::cout << "generating population " << ( p+1 ) << " of " << populations << std::endl;
                 std::stringstream stream;
-                unsigned int index = 0;
-                for( auto it = population->get_town_list_cbegin();
-                     it != population->get_town_list_cend();
-                     ++it, ++index )
-                {
-                  sampsim::town *town = *it;
-                  std::string result = sampsim::utilities::exec( gnuplot( town, population_filename, index ) );
-
-                  stream.str( "" );
-                  stream << population_filename << ".t"
-                         << std::setw( log( population->get_number_of_towns()+1 ) )
-                         << std::setfill( '0' ) << index << ".png";
-                  std::string image_filename = stream.str();
-
-                  stream.str( "" );
-                  if( "ERROR" == result ) stream << "warning: failed to create plot";
-                  else stream << "creating plot file \"" << image_filename << "\"";
-                  sampsim::utilities::output( stream.str() );
-                }
+                stream << ( seed + p );
+                seeded->set_seed( stream.str() );
               }
+
+              generate_population( opts, population, parameters, population_filename );
+              write_population( opts, population, population_filename );
             }
           }
         }
@@ -336,5 +551,6 @@ int main( const int argc, const char** argv )
   }
 
   sampsim::utilities::safe_delete( population );
+  sampsim::utilities::safe_delete( parameters );
   return status;
 }
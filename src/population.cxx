@@ -10,6 +10,7 @@
 // An executable which processes populations in various ways
 //
 
+#include "common.h"
 #include "options.h"
 #include "population.h"
 #include "sample/arc_epi.h"
@@ -23,6 +24,29 @@
 
 #include <stdexcept>
 
+// reads a sample file and writes the requested output files
+template< class T > void process_sample( const std::string base_name, sampsim::options &opts )
+{
+  T *sample = new T;
+  std::string input_filename = opts.get_input( "input_file" );
+  std::string population_filename = opts.get_option( "population_file" );
+  bool flat_file = opts.get_flag( "flat_file" );
+  bool summary_file = opts.get_flag( "summary_file" );
+  bool variance_file = opts.get_flag( "variance_file" );
+
+  // summaries and variances can be written from the file's header without reading the rest of it
+  if( flat_file || !( summary_file || variance_file ) ||
+      !sample->write_summary_from_header( input_filename, base_name, !summary_file ) )
+  {
+    sample->read( input_filename, population_filename );
+    if( flat_file ) sample->write( base_name, true );
+    if( summary_file ) sample->write_summary( base_name );
+    if( summary_file || variance_file ) sample->write_variance( base_name );
+  }
+
+  sampsim::utilities::safe_delete( sample );
+}
+
 // main function
 int main( const int argc, const char** argv )
 {
@@ -36,7 +60,10 @@ int main( const int argc, const char** argv )
   opts.add_flag( 'f', "flat_file", "Whether to output data in two CSV \"flat\" files" );
   opts.add_flag( 's', "summary_file", "Whether to output summary data of the population" );
   opts.add_flag( 'a', "variance_file", "Whether to output variance data of a sample" );
+  opts.add_option( "population_file", "",
+    "The population a sample was drawn from (by default the path stored in the sample is used)" );
   opts.add_flag( 'q', "quiet", "Do not generate any output" );
+  setup_rr( opts );
 
   try
   {
@@ -49,126 +76,70 @@ int main( const int argc, const char** argv )
       {
         opts.print_usage();
       }
-      else
+      else if( process_rr( opts ) )
       {
         std::string input_filename = opts.get_input( "input_file" );
         std::string type = opts.get_option( "type" );
         bool flat_file = opts.get_flag( "flat_file" );
         bool summary_file = opts.get_flag( "summary_file" );
-        bool variance_file = opts.get_flag( "variance_file" );
         sampsim::utilities::quiet = opts.get_flag( "quiet" );
 
         // determine what to do with the input file based on its extention(s)
         std::vector< std::string > parts = sampsim::utilities::explode( input_filename, "." );
         if( 4 > parts.size() ||
-            "gz" != parts.back() ||
+            ( "gz" != parts.back() && "zst" != parts.back() && "lz4" != parts.back() ) ||
             "tar" != parts.at( parts.size()-2 ) ||
             "json" != parts.at( parts.size()-3 ) )
         {
           std::stringstream stream;
-          stream << "Cannot read file \"" << input_filename << "\", only .json.tar.gz files can be read";
+          stream << "Cannot read file \"" << input_filename << "\", only .json.tar.gz, .json.tar.zst and "
+                 << ".json.tar.lz4 files can be read";
           throw std::runtime_error( stream.str() );
         }
 
-        std::string base_name = input_filename.substr( 0, input_filename.size() - 12 );
+        std::string base_name =
+          input_filename.substr( 0, input_filename.size() - 10 - parts.back().size() );
 
         if( "population" == type )
         {
-          sampsim::population *pop = new sampsim::population;
-          pop->read( input_filename );
-          if( flat_file ) pop->write( base_name, true );
-          if( summary_file ) pop->write_summary( base_name );
-          sampsim::utilities::safe_delete( pop );
+          // the summary can be written from the header at the start of the file without reading the rest
+          if( flat_file || !summary_file ||
+              !sampsim::population::write_summary_from_header( input_filename, base_name ) )
+          {
+            sampsim::population *pop = new sampsim::population;
+            pop->read( input_filename );
+            if( flat_file ) pop->write( base_name, true );
+            if( summary_file ) pop->write_summary( base_name );
+            sampsim::utilities::safe_delete( pop );
+          }
         }
         else if( "arc_epi" == type )
         {
-          sampsim::sample::arc_epi *sample = new sampsim::sample::arc_epi;
-          sample->read( input_filename );
-          if( flat_file ) sample->write( base_name, true );
-          if( summary_file )
-          {
-            sample->write_summary( base_name );
-            sample->write_variance( base_name );
-          }
-          sampsim::utilities::safe_delete( sample );
+          process_sample< sampsim::sample::arc_epi >( base_name, opts );
         }
         else if( "circle_gps" == type )
         {
-          sampsim::sample::circle_gps *sample = new sampsim::sample::circle_gps;
-          sample->read( input_filename );
-          if( flat_file ) sample->write( base_name, true );
-          if( summary_file )
-          {
-            sample->write_summary( base_name );
-            sample->write_variance( base_name );
-          }
-          if( variance_file ) sample->write_variance( base_name );
-          sampsim::utilities::safe_delete( sample );
+          process_sample< sampsim::sample::circle_gps >( base_name, opts );
         }
         else if( "enumeration" == type )
         {
-          sampsim::sample::enumeration *sample = new sampsim::sample::enumeration;
-          sample->read( input_filename );
-          if( flat_file ) sample->write( base_name, true );
-          if( summary_file )
-          {
-            sample->write_summary( base_name );
-            sample->write_variance( base_name );
-          }
-          if( variance_file ) sample->write_variance( base_name );
-          sampsim::utilities::safe_delete( sample );
+          process_sample< sampsim::sample::enumeration >( base_name, opts );
         }
         else if( "grid_epi" == type )
         {
-          sampsim::sample::grid_epi *sample = new sampsim::sample::grid_epi;
-          sample->read( input_filename );
-          if( flat_file ) sample->write( base_name, true );
-          if( summary_file )
-          {
-            sample->write_summary( base_name );
-            sample->write_variance( base_name );
-          }
-          if( variance_file ) sample->write_variance( base_name );
-          sampsim::utilities::safe_delete( sample );
+          process_sample< sampsim::sample::grid_epi >( base_name, opts );
         }
         else if( "random" == type )
         {
-          sampsim::sample::random *sample = new sampsim::sample::random;
-          sample->read( input_filename );
-          if( flat_file ) sample->write( base_name, true );
-          if( summary_file )
-          {
-            sample->write_summary( base_name );
-            sample->write_variance( base_name );
-          }
-          if( variance_file ) sample->write_variance( base_name );
-          sampsim::utilities::safe_delete( sample );
+          process_sample< sampsim::sample::random >( base_name, opts );
         }
         else if( "square_gps" == type )
         {
-          sampsim::sample::square_gps *sample = new sampsim::sample::square_gps;
-          sample->read( input_filename );
-          if( flat_file ) sample->write( base_name, true );
-          if( summary_file )
-          {
-            sample->write_summary( base_name );
-            sample->write_variance( base_name );
-          }
-          if( variance_file ) sample->write_variance( base_name );
-          sampsim::utilities::safe_delete( sample );
+          process_sample< sampsim::sample::square_gps >( base_name, opts );
         }
         else if( "strip_epi" == type )
         {
-          sampsim::sample::strip_epi *sample = new sampsim::sample::strip_epi;
-          sample->read( input_filename );
-          if( flat_file ) sample->write( base_name, true );
-          if( summary_file )
-          {
-            sample->write_summary( base_name );
-            sample->write_variance( base_name );
-          }
-          if( variance_file ) sample->write_variance( base_name );
-          sampsim::utilities::safe_delete( sample );
+          process_sample< sampsim::sample::strip_epi >( base_name, opts );
         }
         else
         {
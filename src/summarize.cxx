@@ -0,0 +1,330 @@
+/*=========================================================================
+
+  Program:  sampsim
+  Module:   summarize.cxx
+  Language: C++
+
+=========================================================================*/
+//
+// .SECTION Description
+// An executable which summarizes a tree of sample results into a single CSV file
+//
+
+#include "options.h"
+#include "summary.h"
+#include "summary_accumulator.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <atomic>
+#include <dirent.h>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <thread>
+
+#include <json/reader.h>
+#include <json/value.h>
+
+// returns whether a string ends with the given suffix
+bool ends_with( const std::string str, const std::string suffix )
+{
+  return suffix.size() <= str.size() && 0 == str.compare( str.size() - suffix.size(), suffix.size(), suffix );
+}
+
+// returns whether a file is a (possibly compressed) json archive
+bool is_archive( const std::string filename )
+{
+  return ends_with( filename, ".json.tar.gz" ) ||
+         ends_with( filename, ".json.tar.zst" ) ||
+         ends_with( filename, ".json.tar.lz4" );
+}
+
+// returns whether a file is a sample's summary file (samplers write several other csv files beside it)
+bool is_summary_file( const std::string filename )
+{
+  return ends_with( filename, ".csv" ) &&
+         !ends_with( filename, ".variance.csv" ) &&
+         !ends_with( filename, ".coverage.csv" ) &&
+         !ends_with( filename, ".design_effect.csv" ) &&
+         !ends_with( filename, ".stratified.csv" );
+}
+
+// recursively lists all summary files (or sample archives) below a directory, following links
+void find_files( const std::string path, const bool archives, std::vector< std::string > &file_list )
+{
+  DIR *dir = opendir( path.c_str() );
+  if( NULL == dir ) throw std::runtime_error( "ERROR: unable to read directory \"" + path + "\"" );
+
+  struct dirent *entry;
+  while( NULL != ( entry = readdir( dir ) ) )
+  {
+    std::string name = entry->d_name;
+    if( "." == name || ".." == name ) continue;
+
+    std::string filename = path + "/" + name;
+    struct stat info;
+    if( 0 != stat( filename.c_str(), &info ) ) continue; // ignore broken links
+    if( S_ISDIR( info.st_mode ) ) find_files( filename, archives, file_list );
+    else if( archives ? is_archive( name ) : is_summary_file( name ) )
+      file_list.push_back( filename );
+  }
+  closedir( dir );
+}
+
+// reads the header of a sample archive, returning false if the archive is not a sample (populations also
+// have a header)
+bool read_sample_header( const std::string filename, Json::Value &root )
+{
+  std::string data;
+  Json::Reader reader;
+  return sampsim::utilities::read_first_entry( filename, ".header.json", data ) &&
+         reader.parse( data, root, false ) &&
+         root.isMember( "sample_list" );
+}
+
+// sets the relative risks to those the first sample archive in the list was written with
+void set_rr_from_archives( const std::vector< std::string > &file_list )
+{
+  Json::Value root;
+  for( auto it = file_list.cbegin(); it != file_list.cend(); ++it )
+  {
+    if( !read_sample_header( *it, root ) ) continue;
+
+    std::vector< double > rr_list;
+    const Json::Value &rr = root["population"]["rr"];
+    for( unsigned int index = 0; index < rr.size(); index++ ) rr_list.push_back( rr[index].asDouble() );
+    sampsim::utilities::set_rr( rr_list );
+    return;
+  }
+}
+
+// writes the same summary table a sampler would have written from the header of a sample archive
+// Returns false if the archive is not a sample (populations also have a header)
+bool read_archive( const std::string filename, std::stringstream &stream )
+{
+  Json::Value root;
+  if( !read_sample_header( filename, root ) ) return false;
+
+  // all archives must share the relative risks found by set_rr_from_archives()
+  const Json::Value &rr = root["population"]["rr"];
+  bool same_rr = rr.size() == sampsim::utilities::rr.size();
+  for( unsigned int index = 0; same_rr && index < rr.size(); index++ )
+    same_rr = rr[index].asDouble() == sampsim::utilities::rr[index];
+  if( !same_rr )
+    throw std::runtime_error(
+      "ERROR: \"" + filename + "\" was written with different relative risks than the other archives" );
+
+  sampsim::summary population_summary;
+  if( !population_summary.from_json( root["population"] ) )
+    throw std::runtime_error( "ERROR: invalid population summary in \"" + filename + "\"" );
+  population_summary.write( stream );
+
+  sampsim::summary_accumulator accumulator( root["use_sample_weights"].asBool() );
+  for( unsigned int index = 0; index < root["sample_list"].size(); index++ )
+  {
+    sampsim::summary sum;
+    if( !sum.from_json( root["sample_list"][index]["summary"] ) )
+      throw std::runtime_error( "ERROR: invalid sample summary in \"" + filename + "\"" );
+    accumulator.add( &sum );
+  }
+  accumulator.write( stream );
+  return true;
+}
+
+// population and sample tables don't order multi-word groups the same way (adult male vs male adult)
+std::string get_group_key( const std::string group )
+{
+  std::vector< std::string > words = sampsim::utilities::explode( group, " " );
+  std::sort( words.begin(), words.end() );
+  std::string key;
+  for( auto it = words.cbegin(); it != words.cend(); ++it ) key += ( key.empty() ? "" : " " ) + *it;
+  return key;
+}
+
+// returns the square of the difference between the true and sampled values plus the sampled variance
+std::string get_mse( const std::string truth, const std::string mean, const std::string stdev )
+{
+  double diff = atof( truth.c_str() ) - atof( mean.c_str() ), deviation = atof( stdev.c_str() );
+  std::stringstream stream;
+  stream << ( diff * diff + deviation * deviation );
+  return stream.str();
+}
+
+// converts one sample's summary table into rows of the consolidated table
+std::string summarize_file(
+  const std::string root_path,
+  const std::string filename,
+  const std::vector< std::string > &group_list, // group keys (see get_group_key)
+  const std::vector< std::string > &rr_list )
+{
+  std::stringstream stream;
+  if( is_archive( filename ) )
+  {
+    if( !read_archive( filename, stream ) ) return "";
+  }
+  else
+  {
+    std::ifstream file( filename.c_str() );
+    if( !file.is_open() ) throw std::runtime_error( "ERROR: unable to read file \"" + filename + "\"" );
+    stream << file.rdbuf();
+  }
+
+  // describe the file by its population directory, sampler and name (without extension)
+  std::string relative = filename.substr( root_path.size() + 1 );
+  std::vector< std::string > parts = sampsim::utilities::explode( relative, "/" );
+  std::string name = parts.back();
+  name = name.substr( 0, name.find( is_archive( name ) ? ".json.tar." : ".csv" ) );
+  std::string sampler = 1 < parts.size() ? parts[parts.size()-2] : "";
+  if( ends_with( sampler, "_sample" ) ) sampler = sampler.substr( 0, sampler.size() - 7 );
+  std::string population = 2 < parts.size() ? parts[0] : "";
+  std::string prefix = population + "," + sampler + "," + name + ",";
+
+  // match each sample row with the population row of the same group and rr
+  std::map< std::pair< std::string, std::string >, std::vector< std::string > > population_map;
+  std::stringstream output;
+  std::string line;
+  while( std::getline( stream, line ) )
+  {
+    std::vector< std::string > column = sampsim::utilities::explode( line, "," );
+    if( 3 > column.size() ) continue;
+    std::pair< std::string, std::string > key( get_group_key( column[1] ), column[2] );
+    if( !group_list.empty() &&
+        group_list.cend() == std::find( group_list.cbegin(), group_list.cend(), key.first ) ) continue;
+    if( !rr_list.empty() &&
+        rr_list.cend() == std::find( rr_list.cbegin(), rr_list.cend(), column[2] ) ) continue;
+
+    if( "population" == column[0] && 7 == column.size() )
+    {
+      population_map[key] = column;
+    }
+    else if( "sample" == column[0] && 10 <= column.size() && population_map.count( key ) )
+    {
+      const std::vector< std::string > &truth = population_map[key];
+      output << prefix << column[1] << "," << column[2] << "," << truth[6] << "," << truth[5]
+             << "," << column[8] << "," << column[9] << "," << get_mse( truth[6], column[8], column[9] )
+             << "," << column[5] << "," << column[6] << "," << column[7]
+             << "," << get_mse( truth[5], column[7], column[6] );
+      if( 15 == column.size() )
+      {
+        output << "," << column[13] << "," << column[14] << "," << get_mse( truth[6], column[13], column[14] )
+               << "," << column[10] << "," << column[11] << "," << column[12]
+               << "," << get_mse( truth[5], column[12], column[11] );
+      }
+      else output << ",na,na,na,na,na,na,na";
+      output << std::endl;
+    }
+  }
+
+  return output.str();
+}
+
+// main function
+int main( const int argc, const char** argv )
+{
+  int status = EXIT_FAILURE;
+  sampsim::options opts( argv[0] );
+
+  // define inputs
+  opts.add_input( "results_directory" );
+  opts.add_option( 'o', "output", "", "The CSV file to write to (by default the table is written to stdout)" );
+  opts.add_flag( 'a', "archives", "Read sample archives' embedded summaries instead of summary CSV files" );
+  opts.add_option( 'g', "group", std::vector< std::string >(),
+    "Comma-separated list of groups to include (total, adult, child, male, female, etc; default is all)" );
+  opts.add_option( 'r', "rr_filter", std::vector< std::string >(),
+    "Comma-separated list of individual RR values to include (default is all)" );
+  opts.add_option( 't', "threads", "0", "Number of threads reading files (0 to use one per processor)" );
+  opts.add_flag( 'q', "quiet", "Do not generate any output" );
+
+  try
+  {
+    // parse the command line arguments
+    opts.set_arguments( argc, argv );
+    if( opts.process() )
+    {
+      // now either show the help or run the application
+      if( opts.get_flag( "help" ) )
+      {
+        opts.print_usage();
+      }
+      else
+      {
+        std::string root_path = opts.get_input( "results_directory" );
+        while( 1 < root_path.size() && '/' == root_path.back() ) root_path.pop_back();
+        std::string output_filename = opts.get_option( "output" );
+        std::vector< std::string > group_list = opts.get_option_list( "group" );
+        for( auto it = group_list.begin(); it != group_list.end(); ++it ) *it = get_group_key( *it );
+        std::vector< std::string > rr_list = opts.get_option_list( "rr_filter" );
+        int threads = opts.get_option_as_int( "threads" );
+        sampsim::utilities::quiet = opts.get_flag( "quiet" );
+
+        if( 0 > threads )
+        {
+          std::cout << "ERROR: threads must be 0 or greater" << std::endl;
+        }
+        else
+        {
+          if( 0 == threads ) threads = std::thread::hardware_concurrency();
+          if( 0 == threads ) threads = 1;
+
+          std::vector< std::string > file_list;
+          find_files( root_path, opts.get_flag( "archives" ), file_list );
+          std::sort( file_list.begin(), file_list.end() );
+          if( opts.get_flag( "archives" ) ) set_rr_from_archives( file_list );
+          sampsim::utilities::output(
+            "summarizing %d files using %d threads", static_cast< int >( file_list.size() ), threads );
+
+          // each thread takes the next unread file until there are none left
+          std::vector< std::string > result_list( file_list.size() );
+          std::atomic< unsigned int > next( 0 );
+          std::mutex mutex;
+          std::exception_ptr error;
+          auto worker = [&]()
+          {
+            try
+            {
+              for( unsigned int index = next++; index < file_list.size(); index = next++ )
+                result_list[index] = summarize_file( root_path, file_list[index], group_list, rr_list );
+            }
+            catch( ... )
+            {
+              std::lock_guard< std::mutex > lock( mutex );
+              if( !error ) error = std::current_exception();
+              next = file_list.size();
+            }
+          };
+
+          std::vector< std::thread > thread_list;
+          for( int t = 0; t < threads; t++ ) thread_list.push_back( std::thread( worker ) );
+          for( auto it = thread_list.begin(); it != thread_list.end(); ++it ) it->join();
+          if( error ) std::rethrow_exception( error );
+
+          std::ofstream file;
+          if( !output_filename.empty() )
+          {
+            file.open( output_filename.c_str(), std::ofstream::out );
+            if( !file.is_open() )
+              throw std::runtime_error( "ERROR: unable to write to \"" + output_filename + "\"" );
+          }
+          std::ostream &stream = output_filename.empty() ? std::cout : file;
+          stream << "population,sampler,name,group,individual_rr,true_prevalence,true_rr"
+                 << ",prevalence,stdev,mse,rr,rr_stdev,rr_pooled,mse_rr"
+                 << ",wprevalence,wstdev,wmse,wrr,wrr_stdev,wrr_pooled,wmse_rr" << std::endl;
+          for( auto it = result_list.cbegin(); it != result_list.cend(); ++it ) stream << *it;
+
+          status = EXIT_SUCCESS;
+        }
+      }
+    }
+  }
+  catch( std::exception &e )
+  {
+    std::cerr << "Uncaught exception: " << e.what() << std::endl;
+  }
+
+  return status;
+}